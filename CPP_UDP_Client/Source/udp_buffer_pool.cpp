@@ -0,0 +1,243 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_buffer_pool.cpp
+//!
+//! @brief		Implementation of the udp buffer pool
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_buffer_pool.h"			// UDP Buffer Pool Class
+#include	<new>						// Aligned allocation
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		// Marks the end of the free list.
+		constexpr static uint32_t	BUFFER_POOL_END		= 0xFFFFFFFF;
+
+		PacketBuffer::PacketBuffer()
+		{
+			mPool		= nullptr;
+			mIndex		= 0;
+		}
+
+		PacketBuffer::PacketBuffer(UDP_BufferPool* pool, const uint32_t index)
+		{
+			mPool		= pool;
+			mIndex		= index;
+		}
+
+		PacketBuffer::PacketBuffer(const PacketBuffer& other)
+		{
+			mPool		= other.mPool;
+			mIndex		= other.mIndex;
+
+			if (mPool != nullptr)
+			{
+				mPool->mHeaders[mIndex].references.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		PacketBuffer::PacketBuffer(PacketBuffer&& other) noexcept
+		{
+			mPool		= other.mPool;
+			mIndex		= other.mIndex;
+			other.mPool	= nullptr;
+		}
+
+		PacketBuffer::~PacketBuffer()
+		{
+			Release();
+		}
+
+		PacketBuffer& PacketBuffer::operator=(const PacketBuffer& other)
+		{
+			if (this != &other)
+			{
+				PacketBuffer copy(other);
+				*this = std::move(copy);
+			}
+			return *this;
+		}
+
+		PacketBuffer& PacketBuffer::operator=(PacketBuffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Release();
+				mPool		= other.mPool;
+				mIndex		= other.mIndex;
+				other.mPool	= nullptr;
+			}
+			return *this;
+		}
+
+		PacketBuffer::operator bool() const
+		{
+			return mPool != nullptr;
+		}
+
+		char* PacketBuffer::Data() const
+		{
+			return mPool != nullptr ? mPool->mStorage + mPool->mStride * mIndex : nullptr;
+		}
+
+		uint32_t PacketBuffer::Size() const
+		{
+			return mPool != nullptr ? mPool->mHeaders[mIndex].size : 0;
+		}
+
+		void PacketBuffer::SetSize(const uint32_t size)
+		{
+			if (mPool != nullptr)
+			{
+				mPool->mHeaders[mIndex].size = std::min(size, mPool->mBufferSize);
+			}
+		}
+
+		uint32_t PacketBuffer::Capacity() const
+		{
+			return mPool != nullptr ? mPool->mBufferSize : 0;
+		}
+
+		sockaddr_in& PacketBuffer::Source() const
+		{
+			return mPool->mHeaders[mIndex].source;
+		}
+
+		uint64_t& PacketBuffer::Timestamp() const
+		{
+			return mPool->mHeaders[mIndex].timestamp;
+		}
+
+		bool& PacketBuffer::Truncated() const
+		{
+			return mPool->mHeaders[mIndex].truncated;
+		}
+
+		void PacketBuffer::Release()
+		{
+			if (mPool == nullptr)
+			{
+				return;
+			}
+
+			// The last reference hands the buffer back.
+			if (mPool->mHeaders[mIndex].references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				mPool->Return(mIndex);
+			}
+
+			mPool = nullptr;
+		}
+
+		UDP_BufferPool::UDP_BufferPool(const uint32_t bufferCount, const uint32_t bufferSize)
+		{
+			mBufferCount	= bufferCount;
+			mBufferSize		= bufferSize;
+			mStride			= (static_cast<size_t>(bufferSize) + 63) & ~static_cast<size_t>(63);
+			mStorageSize	= std::max<size_t>(mStride * bufferCount, 1);
+			mHeaders		= new BufferHeader[std::max<uint32_t>(bufferCount, 1)];
+			mStorage		= static_cast<char*>(::operator new(mStorageSize, std::align_val_t(UDP_BUFFER_POOL_ALIGNMENT)));
+			mAvailable		= bufferCount;
+			mHits			= 0;
+			mMisses			= 0;
+
+			// Touch every page now so it is placed on this thread's node and never faults on the receive path.
+			memset(mStorage, 0, mStorageSize);
+
+			for (uint32_t i = 0; i < bufferCount; i++)
+			{
+				mHeaders[i].references = 0;
+				mHeaders[i].next = (i + 1 < bufferCount) ? i + 1 : BUFFER_POOL_END;
+				mHeaders[i].size = 0;
+				mHeaders[i].source = {};
+				mHeaders[i].timestamp = 0;
+				mHeaders[i].truncated = false;
+			}
+
+			mFreeHead = bufferCount > 0 ? 0 : BUFFER_POOL_END;
+		}
+
+		UDP_BufferPool::~UDP_BufferPool()
+		{
+			delete[] mHeaders;
+			::operator delete(mStorage, std::align_val_t(UDP_BUFFER_POOL_ALIGNMENT));
+		}
+
+		PacketBuffer UDP_BufferPool::Acquire()
+		{
+			uint64_t head = mFreeHead.load(std::memory_order_acquire);
+
+			for (;;)
+			{
+				uint32_t index = static_cast<uint32_t>(head & 0xFFFFFFFF);
+
+				if (index == BUFFER_POOL_END)
+				{
+					mMisses.fetch_add(1, std::memory_order_relaxed);
+					return PacketBuffer();
+				}
+
+				// The tag changes on every update, so a stale next from a buffer popped meanwhile fails the exchange.
+				uint64_t tag = (head >> 32) + 1;
+				uint64_t next = mHeaders[index].next.load(std::memory_order_relaxed);
+
+				if (mFreeHead.compare_exchange_weak(head, (tag << 32) | next, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					mHeaders[index].references.store(1, std::memory_order_relaxed);
+					mHeaders[index].size = 0;
+					mHeaders[index].timestamp = 0;
+					mHeaders[index].truncated = false;
+					mAvailable.fetch_sub(1, std::memory_order_relaxed);
+					mHits.fetch_add(1, std::memory_order_relaxed);
+					return PacketBuffer(this, index);
+				}
+			}
+		}
+
+		uint32_t UDP_BufferPool::BufferSize() const
+		{
+			return mBufferSize;
+		}
+
+		BufferPoolStats UDP_BufferPool::GetStats() const
+		{
+			BufferPoolStats stats{};
+			stats.hits = mHits.load(std::memory_order_relaxed);
+			stats.misses = mMisses.load(std::memory_order_relaxed);
+			stats.available = mAvailable.load(std::memory_order_relaxed);
+			stats.capacity = mBufferCount;
+			return stats;
+		}
+
+		void UDP_BufferPool::Return(const uint32_t index)
+		{
+			uint64_t head = mFreeHead.load(std::memory_order_acquire);
+
+			for (;;)
+			{
+				mHeaders[index].next.store(static_cast<uint32_t>(head & 0xFFFFFFFF), std::memory_order_relaxed);
+				uint64_t tag = (head >> 32) + 1;
+
+				if (mFreeHead.compare_exchange_weak(head, (tag << 32) | index, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					mAvailable.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+			}
+		}
+	}
+}
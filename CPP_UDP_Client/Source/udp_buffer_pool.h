@@ -0,0 +1,172 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_buffer_pool.h
+//!
+//! @brief		A fixed-size pool of reference counted packet buffers.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "udp_client.h"					// Socket types
+#include <atomic>						// Free list and reference counts
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_BUFFER_POOL			// Define the cpp UDP buffer pool class.
+#define     CPP_UDP_BUFFER_POOL
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint32_t	UDP_BUFFER_POOL_ALIGNMENT	= 4096;
+
+		/// <summary>Snapshot of a buffer pool's usage</summary>
+		struct BufferPoolStats
+		{
+			uint64_t			hits		= 0;	// Acquires served from the pool
+			uint64_t			misses		= 0;	// Acquires refused because every buffer was in use
+			uint32_t			available	= 0;	// Buffers currently free
+			uint32_t			capacity	= 0;	// Buffers owned by the pool
+		};
+
+		class UDP_BufferPool;
+
+		/// <summary>A reference counted handle to a pooled packet buffer. Copies share the buffer, 
+		/// which goes back to its pool when the last handle is released or destroyed.</summary>
+		class PacketBuffer
+		{
+		public:
+			/// <summary>Default Constructor, an empty handle</summary>
+			PacketBuffer();
+
+			/// <summary>Copy Constructor, shares the buffer</summary>
+			PacketBuffer(const PacketBuffer& other);
+
+			/// <summary>Move Constructor, takes over the buffer</summary>
+			PacketBuffer(PacketBuffer&& other) noexcept;
+
+			/// <summary>Default Deconstructor, releases the buffer</summary>
+			~PacketBuffer();
+
+			PacketBuffer& operator=(const PacketBuffer& other);
+			PacketBuffer& operator=(PacketBuffer&& other) noexcept;
+
+			/// <summary>True if this handle holds a buffer</summary>
+			explicit operator bool() const;
+
+			/// <summary>Get the buffer's storage</summary>
+			/// <returns>Pointer to the data, nullptr for an empty handle</returns>
+			char* Data() const;
+
+			/// <summary>Get the number of bytes held</summary>
+			/// <returns>Number of bytes held</returns>
+			uint32_t Size() const;
+
+			/// <summary>Set the number of bytes held</summary>
+			/// <param name="size"> -[in]- Number of bytes held, at most Capacity</param>
+			void SetSize(const uint32_t size);
+
+			/// <summary>Get the size of the buffer's storage</summary>
+			/// <returns>Size of the storage, 0 for an empty handle</returns>
+			uint32_t Capacity() const;
+
+			/// <summary>Get the sender of the datagram held</summary>
+			/// <returns>Address and port of the sender, network byte order</returns>
+			sockaddr_in& Source() const;
+
+			/// <summary>Get the kernel arrival time of the datagram held</summary>
+			/// <returns>Nanoseconds since the epoch, 0 unless receive timestamps are enabled</returns>
+			uint64_t& Timestamp() const;
+
+			/// <summary>Get whether the datagram held was larger than the buffer</summary>
+			/// <returns>True if the datagram was cut to Capacity bytes</returns>
+			bool& Truncated() const;
+
+			/// <summary>Drops this handle's reference, the handle is empty afterwards</summary>
+			void Release();
+
+		protected:
+		private:
+			friend class UDP_BufferPool;
+
+			/// <summary>Constructor used by the pool, takes over the buffer's first reference</summary>
+			PacketBuffer(UDP_BufferPool* pool, const uint32_t index);
+
+			UDP_BufferPool*				mPool;					// Pool owning the buffer, nullptr for an empty handle
+			uint32_t					mIndex;					// Index of the buffer in its pool
+		};
+
+		/// <summary>A preallocated slab of equally sized, cache aligned packet buffers with a lock-free free list.
+		/// Construct it on the thread (and so the NUMA node) that fills the buffers; the memory is touched up front.</summary>
+		class UDP_BufferPool
+		{
+		public:
+			/// <summary>Constructor to allocate every buffer up front</summary>
+			/// <param name="bufferCount"> -[in]- Number of buffers</param>
+			/// <param name="bufferSize"> -[in]- Size of each buffer</param>
+			UDP_BufferPool(const uint32_t bufferCount, const uint32_t bufferSize);
+
+			/// <summary>Default Deconstructor, every handle must be released first</summary>
+			~UDP_BufferPool();
+
+			UDP_BufferPool(const UDP_BufferPool&) = delete;
+			UDP_BufferPool& operator=(const UDP_BufferPool&) = delete;
+
+			/// <summary>Takes a free buffer out of the pool</summary>
+			/// <returns>Handle to the buffer, an empty handle if every buffer is in use</returns>
+			PacketBuffer Acquire();
+
+			/// <summary>Get the size of each buffer</summary>
+			/// <returns>Size of each buffer</returns>
+			uint32_t BufferSize() const;
+
+			/// <summary>Get the pool's usage</summary>
+			/// <returns>Hit, miss and availability counts</returns>
+			BufferPoolStats GetStats() const;
+
+		protected:
+		private:
+			friend class PacketBuffer;
+
+			/// <summary>Per-buffer bookkeeping, kept apart from the data so headers never share a line with payloads</summary>
+			struct alignas(64) BufferHeader
+			{
+				std::atomic<uint32_t>	references;				// Handles sharing the buffer
+				std::atomic<uint32_t>	next;					// Next free buffer while on the free list
+				uint32_t				size;					// Number of bytes held
+				sockaddr_in				source;					// Sender of the datagram held
+				uint64_t				timestamp;				// Kernel arrival time of the datagram held
+				bool					truncated;				// True if the datagram held was cut to the buffer size
+			};
+
+			/// <summary>Puts a buffer back on the free list</summary>
+			/// <param name="index"> -[in]- Index of the buffer</param>
+			void Return(const uint32_t index);
+
+			BufferHeader*				mHeaders;				// Header of each buffer
+			char*						mStorage;				// Buffer storage, one aligned block
+			size_t						mStorageSize;			// Size of the storage block
+			size_t						mStride;				// Distance between buffers
+			uint32_t					mBufferCount;			// Number of buffers
+			uint32_t					mBufferSize;			// Size of each buffer
+			std::atomic<uint64_t>		mFreeHead;				// Free list head index, tagged in the upper half against ABA
+			std::atomic<uint32_t>		mAvailable;				// Number of free buffers
+			std::atomic<uint64_t>		mHits;					// Acquires served
+			std::atomic<uint64_t>		mMisses;				// Acquires refused
+		};
+	}
+}
+
+#endif		// CPP_UDP_BUFFER_POOL
@@ -16,6 +16,10 @@
 //          name                        reason included
 //          --------------------        ---------------------------------------
 #include	"udp_client.h"				// UDP Client Class
+#include	"udp_uring.h"				// io_uring backend
+#include	"udp_packet_ring.h"			// Receive thread ring and send queue
+#include	"udp_buffer_pool.h"			// Pooled receive buffers
+#include	"udp_socket_filter.h"		// Socket filter programs
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -23,6 +27,17 @@ namespace Essentials
 {
 	namespace Communications
 	{
+		// Marks a listener index that refers to mSharedMulticastSockets rather than mMulticastSockets.
+		constexpr static size_t		UDP_SHARED_LISTENER			= 0x80000000;
+
+		// Tags the listener event of the unicast socket waiting for room to drain the send queue.
+		constexpr static uint64_t	UDP_SEND_QUEUE_EVENT		= 0xFF;
+
+#if defined __linux__
+		// Room for a drop count and a set of timestamps alongside each received datagram.
+		constexpr static size_t		UDP_RECEIVE_CONTROL_SIZE	= CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(scm_timestamping));
+#endif
+
 		UDP_Client::UDP_Client()
 		{
 			mTitle				= "UDP Client";
@@ -47,6 +62,32 @@ namespace Essentials
 #endif
 			mSocket				= INVALID_SOCKET;
 			mBroadcastSocket	= INVALID_SOCKET;
+			mListenerPoll		= INVALID_SOCKET;
+			mUring				= nullptr;
+#if defined __linux__
+			mSegmentOffload		= true;
+#else
+			mSegmentOffload		= false;
+#endif
+			mReceiveCoalescing	= false;
+			mZeroCopy			= false;
+			mReceiveRing		= nullptr;
+			mSendQueue			= nullptr;
+			mSendQueueHighWater	= 0;
+			mSendQueueAboveHighWater = false;
+			mSendQueueDrops		= 0;
+			mSendQueueEnabled	= false;
+			mSendQueueWatched	= false;
+			mReceiveThreadRunning = false;
+			mShardsRunning		= false;
+			mPeerPinned			= false;
+			mSharedMulticast	= false;
+			mDropAccounting		= false;
+			mKernelDrops		= 0;
+			mBusyPollBudget		= 0;
+			mReceiveTimestamps	= false;
+			mHardwareTimestamps	= false;
+			mTransmitTime		= false;
 		}
 
 		UDP_Client::UDP_Client(const std::string& clientsAddress, const int16_t clientsPort)
@@ -90,13 +131,69 @@ namespace Essentials
 #endif
 			mSocket				= INVALID_SOCKET;
 			mBroadcastSocket	= INVALID_SOCKET;
+			mListenerPoll		= INVALID_SOCKET;
+			mUring				= nullptr;
+#if defined __linux__
+			mSegmentOffload		= true;
+#else
+			mSegmentOffload		= false;
+#endif
+			mReceiveCoalescing	= false;
+			mZeroCopy			= false;
+			mReceiveRing		= nullptr;
+			mSendQueue			= nullptr;
+			mSendQueueHighWater	= 0;
+			mSendQueueAboveHighWater = false;
+			mSendQueueDrops		= 0;
+			mSendQueueEnabled	= false;
+			mSendQueueWatched	= false;
+			mReceiveThreadRunning = false;
+			mShardsRunning		= false;
+			mPeerPinned			= false;
+			mSharedMulticast	= false;
+			mDropAccounting		= false;
+			mKernelDrops		= 0;
+			mBusyPollBudget		= 0;
+			mReceiveTimestamps	= false;
+			mHardwareTimestamps	= false;
+			mTransmitTime		= false;
+		}
+
+		UDP_Client::UDP_Client(const IoBackend backend) : UDP_Client()
+		{
+			if (backend == IoBackend::IO_URING)
+			{
+				mUring = new UDP_Uring();
+
+				// Keep the POSIX path if this kernel cannot run the engine.
+				if (mUring->Initialize(UDP_URING_DEFAULT_ENTRIES, UDP_URING_DEFAULT_BUFFER_COUNT, UDP_URING_DEFAULT_BUFFER_SIZE) < 0)
+				{
+					delete mUring;
+					mUring = nullptr;
+				}
+			}
 		}
 
 		UDP_Client::~UDP_Client()
 		{
+			StopReceiveThread();
+			StopShardedReceive();
 			CloseUnicast();
 			CloseBroadcast();
 			CloseMulticast();
+			EnableSendQueue(0, 0);
+
+			if (mUring != nullptr)
+			{
+				delete mUring;
+				mUring = nullptr;
+			}
+
+			if (mListenerPoll != INVALID_SOCKET)
+			{
+				closesocket(mListenerPoll);
+				mListenerPoll = INVALID_SOCKET;
+			}
 
 #ifdef WIN32
 			WSACleanup();
@@ -154,9 +251,73 @@ namespace Essentials
 				return -1;
 			}
 
+			// Keep a pinned socket connected to the current destination.
+			if (mPeerPinned)
+			{
+				return PinUnicastPeer();
+			}
+
+			return 0;
+		}
+
+		int8_t UDP_Client::PinUnicastPeer()
+		{
+			// verify socket
+			if (mSocket == INVALID_SOCKET)
+			{
+				mLastError = UdpClientError::PIN_PEER_FAILED;
+				return -1;
+			}
+
+			if (connect(mSocket, (const sockaddr*)&mDestinationAddr, sizeof(mDestinationAddr)) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::PIN_PEER_FAILED;
+				return -1;
+			}
+
+			// Every receive now comes from the peer, record it once instead of per datagram.
+			mLastReceiveInfo->port = ntohs(mDestinationAddr.sin_port);
+
+			char addr[INET_ADDRSTRLEN];
+			if (inet_ntop(AF_INET, &(mDestinationAddr.sin_addr), addr, INET_ADDRSTRLEN) != NULL)
+			{
+				mLastReceiveInfo->ipAddress = addr;
+			}
+
+			mPeerPinned = true;
+			return 0;
+		}
+
+		int8_t UDP_Client::UnpinUnicastPeer()
+		{
+			if (!mPeerPinned)
+			{
+				return 0;
+			}
+
+			// Connecting to an unspecified address dissolves the association.
+			sockaddr_in unspecified{};
+#ifdef WIN32
+			unspecified.sin_family = AF_INET;
+#else
+			unspecified.sin_family = AF_UNSPEC;
+#endif
+
+			if (connect(mSocket, (const sockaddr*)&unspecified, sizeof(unspecified)) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::PIN_PEER_FAILED;
+				return -1;
+			}
+
+			mPeerPinned = false;
 			return 0;
 		}
 
+		bool UDP_Client::IsUnicastPeerPinned()
+		{
+			return mPeerPinned;
+		}
+
 		int8_t UDP_Client::EnableBroadcastSender(const int16_t port)
 		{
 			if(mBroadcastSocket != INVALID_SOCKET)
@@ -187,13 +348,18 @@ namespace Essentials
 			mBroadcastAddr.sin_addr.s_addr = INADDR_BROADCAST;
 
 			// set broadcast option
-			int8_t broadcast = 1;
+			int broadcast = 1;
 			if (setsockopt(mBroadcastSocket, SOL_SOCKET, SO_BROADCAST, (char*)&broadcast, sizeof(broadcast)) < 0)
 			{
 				mLastError = UdpClientError::ENABLE_BROADCAST_FAILED;
 				return -1;
 			}
 
+			if (ApplySocketOptions(mBroadcastSocket, SendType::BROADCAST) < 0)
+			{
+				return -1;
+			}
+
 			// success
 			return 0;
 		}
@@ -220,6 +386,12 @@ namespace Essentials
 			addr.sin_port = htons(port);
 			addr.sin_addr.s_addr = INADDR_ANY;
 
+			if (ApplySocketOptions(sock, SendType::BROADCAST) < 0)
+			{
+				closesocket(sock);
+				return -1;
+			}
+
 			if (bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR)
 			{
 				mLastError = UdpClientError::BIND_FAILED;
@@ -228,6 +400,24 @@ namespace Essentials
 
 			Endpoint ep{ "", port };
 
+			if (mUring != nullptr && mUring->ArmReceive(sock, SendType::BROADCAST) < 0)
+			{
+				closesocket(sock);
+				mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
+				return -1;
+			}
+
+			if (RegisterListener(sock, SendType::BROADCAST, mBroadcastListeners.size()) < 0)
+			{
+				if (mUring != nullptr)
+				{
+					mUring->CancelReceive(sock);
+				}
+
+				closesocket(sock);
+				return -1;
+			}
+
 			mBroadcastListeners.push_back({sock,addr,ep});
 
 			return 0;
@@ -268,6 +458,11 @@ namespace Essentials
 		}
 
 		int8_t UDP_Client::AddMulticastGroup(const std::string& groupIP, const int16_t groupPort)
+		{
+			return AddMulticastGroup(groupIP, groupPort, {});
+		}
+
+		int8_t UDP_Client::AddMulticastGroup(const std::string& groupIP, const int16_t groupPort, const std::vector<std::string>& sources)
 		{
 			if (ValidateIP(groupIP) == -1)
 			{
@@ -283,24 +478,6 @@ namespace Essentials
 
 			Endpoint ep = { groupIP, groupPort };
 
-			// Create a UDP socket
-			SOCKET sock = socket(AF_INET, SOCK_DGRAM, 0);
-
-			if (sock == INVALID_SOCKET)
-			{
-				mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
-				return 1;
-			}
-
-			// Enable SO_REUSEADDR to allow multiple sockets to bind to the same address
-			int8_t reuseAddr = 1;
-			if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuseAddr, sizeof(reuseAddr)) == SOCKET_ERROR)
-			{
-				closesocket(sock);
-				mLastError = UdpClientError::ENABLE_REUSEADDR_FAILED;
-				return -1;
-			}
-
 			// Set up the multicast group to send and receive data from
 			sockaddr_in multicastAddr{};
 			multicastAddr.sin_family = AF_INET;
@@ -311,669 +488,4086 @@ namespace Essentials
 				return -1;
 			}
 
-			// Bind the socket to a local IP address
-			sockaddr_in localAddr{};
-			localAddr.sin_family = AF_INET;
-			localAddr.sin_port = htons(groupPort);
-			localAddr.sin_addr.s_addr = INADDR_ANY;
-
-			// Bind the socket to the multicast address
-			if (bind(sock, (sockaddr*)&localAddr, sizeof(localAddr)) < 0)
+			// Resolve the sources up front so a bad one leaves nothing half joined.
+			std::vector<in_addr> sourceAddrs(sources.size());
+			for (size_t i = 0; i < sources.size(); i++)
 			{
-				mLastError = UdpClientError::MULTICAST_BIND_FAILED;
-				return 1;
+				if (inet_pton(AF_INET, sources[i].c_str(), &sourceAddrs[i]) != 1)
+				{
+					mLastError = UdpClientError::BAD_ADDRESS;
+					return -1;
+				}
 			}
 
-			// Set the TTL (time to live) for any outpoing multicast packets to 5 hops
-			if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&mTimeToLive, sizeof(mTimeToLive)) == SOCKET_ERROR)
+			if (mSharedMulticast)
 			{
-				mLastError = UdpClientError::MULTICAST_SET_TTL_FAILED;
-				return -1;
-			}
+				int32_t shared = AcquireSharedMulticastSocket(groupPort);
+				if (shared < 0)
+				{
+					return -1;
+				}
 
-			// Set the outgoing interface for multicast packets
-			in_addr interfaceAddr {};
-			interfaceAddr.s_addr = INADDR_ANY;
-			if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, (char*)&interfaceAddr, sizeof(interfaceAddr)) < 0) 
-			{
-				mLastError = UdpClientError::MULTICAST_INTERFACE_ERROR;
-				return -1;
+				// A socket can run out of memberships below our own limit, move on to a fresh one once.
+				if (JoinMulticastGroup(mSharedMulticastSockets[shared].sock, multicastAddr.sin_addr, sourceAddrs) < 0)
+				{
+					// Any other failure would fail on a fresh socket too, and says nothing about this one's room.
+#ifdef WIN32
+					int errorCode = WSAGetLastError();
+					if (errorCode != WSAENOBUFS)
+#else
+					if (errno != ENOBUFS && errno != ENOMEM)
+#endif
+					{
+						mLastError = UdpClientError::ADD_MULTICAST_GROUP_FAILED;
+						return -1;
+					}
+
+					mSharedMulticastSockets[shared].groups = UDP_MAX_GROUPS_PER_SOCKET;
+					size_t opened = mSharedMulticastSockets.size();
+					shared = AcquireSharedMulticastSocket(groupPort);
+
+					if (shared < 0)
+					{
+						return -1;
+					}
+
+					if (JoinMulticastGroup(mSharedMulticastSockets[shared].sock, multicastAddr.sin_addr, sourceAddrs) < 0)
+					{
+						// Don't keep a socket opened for this group alone with nothing joined on it.
+						if (static_cast<size_t>(shared) == opened)
+						{
+							SOCKET sock = mSharedMulticastSockets[shared].sock;
+
+							if (mUring != nullptr)
+							{
+								mUring->CancelReceive(sock);
+							}
+
+							mZeroCopyStates.erase(sock);
+							mListenerIndex.erase(sock);
+							closesocket(sock);
+							mSharedMulticastSockets.pop_back();
+						}
+
+						mLastError = UdpClientError::ADD_MULTICAST_GROUP_FAILED;
+						return -1;
+					}
+				}
+
+				mSharedMulticastSockets[shared].groups++;
+				mMulticastSockets.push_back({ mSharedMulticastSockets[shared].sock, multicastAddr, ep });
+				mMulticastGroupIndex[multicastAddr.sin_addr.s_addr].push_back(mMulticastSockets.size() - 1);
+				return 0;
 			}
 
-			// Join the multicast group
-			ip_mreq multicastRequest{};
-			if (inet_pton(AF_INET, groupIP.c_str(), &(multicastRequest.imr_multiaddr)) <= 0)
+			SOCKET sock = OpenMulticastSocket(groupPort, false);
+
+			if (sock == INVALID_SOCKET)
 			{
-				mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
 				return -1;
 			}
 
-			multicastRequest.imr_interface.s_addr = INADDR_ANY;
-			if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&multicastRequest, sizeof(multicastRequest)) == SOCKET_ERROR)
+			if (JoinMulticastGroup(sock, multicastAddr.sin_addr, sourceAddrs) < 0)
 			{
 				mLastError = UdpClientError::ADD_MULTICAST_GROUP_FAILED;
 				closesocket(sock);
 				return -1;
 			}
 
-			// Set the socket to non-blocking mode
-#ifdef WIN32
-			u_long mode = 1;
-			if (ioctlsocket(sock, FIONBIO, &mode) != 0) 
+			if (mZeroCopy && ConfigureZeroCopy(sock, true) < 0)
 			{
 				closesocket(sock);
 				return -1;
 			}
-#else
-			int flags = fcntl(sock, F_GETFL, 0);
-			if (flags == -1)
+
+			if (mUring != nullptr && mUring->ArmReceive(sock, SendType::MULTICAST) < 0)
 			{
-				mLastError = UdpClientError::FAILED_TO_GET_SOCKET_FLAGS;
+				closesocket(sock);
+				mLastError = UdpClientError::READ_FAILED;
 				return -1;
 			}
 
-			if (fcntl(sock, F_SETFL, flags | O_NONBLOCK) == -1)
+			if (RegisterListener(sock, SendType::MULTICAST, mMulticastSockets.size()) < 0)
 			{
-				mLastError = UdpClientError::FAILED_TO_SET_NONBLOCK;
+				if (mUring != nullptr)
+				{
+					mUring->CancelReceive(sock);
+				}
+
+				mZeroCopyStates.erase(sock);
+				closesocket(sock);
 				return -1;
 			}
-#endif
 
 			mMulticastSockets.push_back({ sock, multicastAddr, ep });
+			mMulticastGroupIndex[multicastAddr.sin_addr.s_addr].push_back(mMulticastSockets.size() - 1);
 
 			return 0;
 		}
 
-		int8_t UDP_Client::OpenUnicast()
+		int8_t UDP_Client::SetSharedMulticastSockets(const bool enable)
 		{
-			if (mSocket != -1)
+#if defined __linux__
+			// The io_uring engine's packets carry no destination group to tell shared groups apart by.
+			if (enable && mUring != nullptr)
 			{
-				mLastError = UdpClientError::CLIENT_ALREADY_CONNECTED;
-				return -1;
-			}
-
-			mSocket = socket(AF_INET, SOCK_DGRAM, 0);
-
-			if (mSocket == INVALID_SOCKET)
-			{
-				mLastError = UdpClientError::SOCKET_OPEN_FAILURE;
+				mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
 				return -1;
 			}
 
-			// Set as nonblocking socket
-#ifdef WIN32
-			u_long nonBlockingMode = 1;
-			if (ioctlsocket(mSocket, FIONBIO, &nonBlockingMode) != 0)
-			{
-				mLastError = UdpClientError::FAILED_TO_SET_NONBLOCK;
-				return -1;
-			}
+			mSharedMulticast = enable;
+			return 0;
 #else
-			int flags = fcntl(mSocket, F_GETFL, 0);
-			if (flags == -1)
+			if (!enable)
 			{
-				mLastError = UdpClientError::FAILED_TO_GET_SOCKET_FLAGS;
-				return -1;
+				return 0;
 			}
 
-			if (fcntl(mSocket, F_SETFL, flags | O_NONBLOCK) == -1)
-			{
-				mLastError = UdpClientError::FAILED_TO_SET_NONBLOCK;
-				return -1;
-			}
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
+			return -1;
 #endif
-			// Set reuseable address. 
-			int8_t opt = 1;
-			if (setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt)) < 0)
+		}
+
+		int8_t UDP_Client::AttachFilter(const SendType type, const UDP_SocketFilter& filter)
+		{
+#if defined __linux__
+			if (filter.IsInvalid())
 			{
-				mLastError = UdpClientError::ENABLE_REUSEADDR_FAILED;
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
 				return -1;
 			}
 
-			if (bind(mSocket,(sockaddr*)&mClientAddr, sizeof(mClientAddr)) < 0)
+			mFilters[static_cast<size_t>(type)] = filter.Build();
+
+			for (SOCKET sock : GetSockets(type))
 			{
-				mLastError = UdpClientError::BIND_FAILED;
-				return -1;
+				if (ApplyFilter(sock, type) < 0)
+				{
+					return -1;
+				}
 			}
 
 			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
+			return -1;
+#endif
 		}
 
-		int8_t UDP_Client::Send(const char* buffer, const uint32_t size, const SendType type)
+		int8_t UDP_Client::DetachFilter(const SendType type)
 		{
-			switch (type)
+#if defined __linux__
+			mFilters[static_cast<size_t>(type)].clear();
+
+			for (SOCKET sock : GetSockets(type))
 			{
-			case SendType::UNICAST:		return SendUnicast(buffer, size);	break;
-			case SendType::BROADCAST:	return SendBroadcast(buffer, size); break;
-			case SendType::MULTICAST:	return SendMulticast(buffer, size); break;
-			default: return -1;
+				// Fails with ENOENT on sockets that never had a filter, which is what we want anyway.
+				int unused = 0;
+				setsockopt(sock, SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused));
 			}
 
-			// default return
+			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
 			return -1;
+#endif
 		}
 
-		int8_t UDP_Client::SendUnicast(const char* buffer, const uint32_t size)
+		int8_t UDP_Client::SetSocketBufferSizes(const SendType type, const int32_t receiveBytes, const int32_t sendBytes)
 		{
-			// verify socket and then send datagram
-			if (mSocket != INVALID_SOCKET)
+			if (receiveBytes < 0 || sendBytes < 0)
 			{
-				int32_t numSent = sendto(mSocket, buffer, size, 0, (sockaddr*)&mDestinationAddr, sizeof(mDestinationAddr));
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+				return -1;
+			}
 
-				if (numSent == -1)
+			mBufferSizes[static_cast<size_t>(type)].receive = receiveBytes;
+			mBufferSizes[static_cast<size_t>(type)].send = sendBytes;
+
+			for (SOCKET sock : GetSockets(type))
+			{
+				if (ApplyBufferSizes(sock, type) < 0)
 				{
-					mLastError = UdpClientError::SEND_FAILED;
 					return -1;
 				}
-
-				// return success
-				return numSent;
 			}
 
-			// default return
-			return -1;
+			return 0;
 		}
 
-		int8_t UDP_Client::SendUnicast(const char* buffer, const uint32_t size, const std::string& ipAddress, const int16_t port)
+		int8_t UDP_Client::GetSocketBufferSizes(const SendType type, int32_t& receiveBytes, int32_t& sendBytes)
 		{
-			// verify socket and then send datagram
-			if (mSocket != INVALID_SOCKET)
-			{
-				if (ValidateIP(ipAddress) == -1)
-				{
-					mLastError = UdpClientError::BAD_ADDRESS;
-					return -1;
-				}
+			std::vector<SOCKET> sockets = GetSockets(type);
 
-				if (ValidatePort(port) == false)
-				{
-					mLastError = UdpClientError::BAD_PORT;
-					return -1;
-				}
-
-				// Setup mDestinationAddr
-				sockaddr_in sentTo{};
-				memset(reinterpret_cast<char*>(&sentTo), 0, sizeof(sentTo));
-				sentTo.sin_family = AF_INET;
-				sentTo.sin_port = htons(port);
-				if (inet_pton(AF_INET, ipAddress.c_str(), &(sentTo.sin_addr)) <= 0)
-				{
-					mLastError = UdpClientError::SET_DESTINATION_FAILED;
-					return -1;
-				}
-
-				int32_t numSent = 0;
-				numSent = sendto(mSocket, buffer, size, 0, (sockaddr*)&sentTo, sizeof(sentTo));
+			if (sockets.empty())
+			{
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+				return -1;
+			}
 
-				if (numSent == -1)
-				{
-					mLastError = UdpClientError::SEND_FAILED;
-					return -1;
-				}
+			int receive = 0;
+			int send = 0;
+			socklen_t receiveLength = sizeof(receive);
+			socklen_t sendLength = sizeof(send);
 
-				// return success
-				return numSent;
+			if (getsockopt(sockets.front(), SOL_SOCKET, SO_RCVBUF, (char*)&receive, &receiveLength) == SOCKET_ERROR ||
+				getsockopt(sockets.front(), SOL_SOCKET, SO_SNDBUF, (char*)&send, &sendLength) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+				return -1;
 			}
 
-			// default return
-			return -1;
+			receiveBytes = receive;
+			sendBytes = send;
+			return 0;
 		}
 
-		int8_t UDP_Client::SendBroadcast(const char* buffer, const uint32_t size)
+		int8_t UDP_Client::EnableDropAccounting(const bool enable)
 		{
-			// verify socket and then send datagram
-			if (mBroadcastSocket != INVALID_SOCKET)
-			{
-				int32_t numSent = sendto(mBroadcastSocket, buffer, size, 0, (sockaddr*)&mBroadcastAddr, sizeof(sockaddr_in));
+#if defined __linux__
+			int value = enable ? 1 : 0;
 
-				if (numSent == -1)
+			for (SendType type : { SendType::UNICAST, SendType::BROADCAST, SendType::MULTICAST })
+			{
+				for (SOCKET sock : GetSockets(type))
 				{
-					mLastError = UdpClientError::SEND_BROADCAST_FAILED;
-					return -1;
+					if (setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &value, sizeof(value)) == SOCKET_ERROR)
+					{
+						mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+						return -1;
+					}
 				}
-
-				// return success
-				return numSent;
 			}
 
-			// default return
+			mDropAccounting = enable;
+			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
 			return -1;
+#endif
 		}
 
-		int8_t UDP_Client::SendMulticast(const char* buffer, const uint32_t size, const std::string& groupIP)
+		bool UDP_Client::IsTransmitTimeEnabled()
 		{
-			// verify socket and then send datagram
-			if (mMulticastSockets.size() > 0)
-			{
-				int32_t numSent = 0;
-				for (const auto& i : mMulticastSockets)
-				{
-					// Grab the socket and addr info from the vector for use.
-					SOCKET sock = std::get<0>(i);
-					sockaddr_in addr = std::get<1>(i);
-					Endpoint ep = std::get<2>(i);
+			return mTransmitTime;
+		}
 
-					// If groupIP is not empty, check the IP we are currently sending to and only send to the desired group.
-					if (!groupIP.empty() && groupIP != ep.ipAddress)
-					{
-						continue;
-					}
+		uint32_t UDP_Client::GetKernelDropCount()
+		{
+			return mKernelDrops;
+		}
 
-					numSent = sendto(sock, buffer, size, 0, (sockaddr*)&addr, sizeof(sockaddr_in));
+		std::unordered_map<SOCKET, uint32_t> UDP_Client::GetKernelDropCounts()
+		{
+			std::lock_guard<std::mutex> lock(mDropLock);
+			return mSocketDrops;
+		}
 
-					if (numSent < 0)
+		int8_t UDP_Client::EnableReceiveTimestamps(const bool enable, const bool hardware)
+		{
+#if defined __linux__
+			mReceiveTimestamps = enable;
+			mHardwareTimestamps = enable && hardware;
+
+			for (SendType type : { SendType::UNICAST, SendType::BROADCAST, SendType::MULTICAST })
+			{
+				for (SOCKET sock : GetSockets(type))
+				{
+					if (ApplyTimestamps(sock) < 0)
 					{
-						mLastError = UdpClientError::SEND_MULTICAST_FAILED;
-						return false;
+						return -1;
 					}
 				}
-
-				return numSent;
 			}
 
+			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
 			return -1;
+#endif
 		}
 
-		int8_t UDP_Client::ReceiveUnicast(void* buffer, const uint32_t maxSize)
+		int8_t UDP_Client::EnableTransmitTime(const bool enable)
 		{
-			// Store the data source info
-			sockaddr_in sourceAddress{};
-			int addressLength = sizeof(sourceAddress);
-
-			// Receive datagram over UDP
-#if defined WIN32
-			int32_t sizeRead = recvfrom(mSocket, reinterpret_cast<char*>(buffer), maxSize-1, 0, (sockaddr*)&sourceAddress, &addressLength);
-#else
-			int32_t sizeRead = recvfrom(mSocket, buffer, static_cast<size_t>(maxSize) - 1, 0, (sockaddr*)&sourceAddress, reinterpret_cast<socklen_t*>(&addressLength));
-#endif
+#if defined __linux__
+			mTransmitTime = enable;
 
-			// Check for error
-			if (sizeRead == -1)
+			for (SendType type : { SendType::UNICAST, SendType::MULTICAST })
 			{
-#ifdef WIN32
-				int errorCode = WSAGetLastError();
-				if (errorCode != WSAEWOULDBLOCK)
-				{
-					mLastError = UdpClientError::READ_FAILED;
-					return -1;
-				}
-#else
-				if (errno != EWOULDBLOCK)
+				for (SOCKET sock : GetSockets(type))
 				{
-					mLastError = UdpClientError::READ_FAILED;
-					return -1;
+					if (ApplyTransmitTime(sock) < 0)
+					{
+						return -1;
+					}
 				}
-#endif
-				return 0;
 			}
 
-			// if data was received, store the port and ip for history. 
-			if (sizeRead > 0)
-			{
-				mLastReceiveInfo->port = ntohs(sourceAddress.sin_port);
-
-				char addr[INET_ADDRSTRLEN];
-				if (inet_ntop(AF_INET, &(sourceAddress.sin_addr), addr, INET_ADDRSTRLEN) != NULL)
-				{
-					mLastReceiveInfo->ipAddress = addr;
-				}
-			}
+			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
+			return -1;
+#endif
+		}
 
-			// return size read
-			return sizeRead;
+		LatencyHistogram UDP_Client::GetQueueDelayHistogram()
+		{
+			std::lock_guard<std::mutex> lock(mQueueDelayLock);
+			return mQueueDelay;
 		}
 
-		int8_t UDP_Client::ReceiveUnicast(void* buffer, const uint32_t maxSize, std::string& recvFromAddr, int16_t& recvFromPort)
+		void UDP_Client::ResetQueueDelayHistogram()
 		{
-			int8_t rtn = ReceiveUnicast(buffer, maxSize);
+			std::lock_guard<std::mutex> lock(mQueueDelayLock);
+			mQueueDelay.Reset();
+		}
 
-			if (rtn > 0)
+		int8_t UDP_Client::SetReceiveCoalescing(const bool enable)
+		{
+#if defined __linux__
+			if (mSocket != INVALID_SOCKET)
 			{
-				recvFromAddr = GetIpOfLastReceive();
-				recvFromPort = GetPortOfLastReceive();
+				int value = enable ? 1 : 0;
+				if (setsockopt(mSocket, SOL_UDP, UDP_GRO, &value, sizeof(value)) == SOCKET_ERROR)
+				{
+					mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+					return -1;
+				}
 			}
 
-			return rtn;;
+			mReceiveCoalescing = enable;
+			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
+			return -1;
+#endif
 		}
 
-		int8_t UDP_Client::ReceiveBroadcast(void* buffer, const uint32_t maxSize)
+		int8_t UDP_Client::OpenUnicast()
 		{
-			if (mBroadcastListeners.size() > 0)
+			if (mSocket != -1)
 			{
-				for (const auto& i : mBroadcastListeners)
-				{
-					// Grab the socket and addr info from the vector for use.
-					SOCKET sock = std::get<0>(i);
-					sockaddr_in addr = std::get<1>(i);
+				mLastError = UdpClientError::CLIENT_ALREADY_CONNECTED;
+				return -1;
+			}
 
-					if (sock != INVALID_SOCKET)
-					{
-						// Verify incoming data is available.
-						fd_set readSet{};
-						FD_ZERO(&readSet);
-						FD_SET(sock, &readSet);
-						sockaddr_in recvFrom{};
-						int recvFromSize = sizeof(recvFrom);
-						
-						int selectResult = select((int)sock + 1, &readSet, nullptr, nullptr, &mTimeout);
-						
-						// Catch error
-						if (selectResult == SOCKET_ERROR)
-						{
-							mLastError = UdpClientError::SELECT_READ_ERROR;
-							return 1;
-						}
+			mSocket = socket(AF_INET, SOCK_DGRAM, 0);
 
-						// If data is available on this socket, attempt to read it 
-						if (selectResult > 0)
-						{
-#if defined WIN32
-							int32_t receivedBytes = recvfrom(sock, (char*)buffer, maxSize-1, 0, reinterpret_cast<sockaddr*>(&recvFrom), &recvFromSize);
-#else
-							int32_t receivedBytes = recvfrom(mSocket, buffer, static_cast<size_t>(maxSize) - 1, 0, (sockaddr*)&recvFrom, reinterpret_cast<socklen_t*>(&recvFromSize));
-#endif
+			if (mSocket == INVALID_SOCKET)
+			{
+				mLastError = UdpClientError::SOCKET_OPEN_FAILURE;
+				return -1;
+			}
 
-							if (receivedBytes == SOCKET_ERROR)
-							{
+			// Set as nonblocking socket
 #ifdef WIN32
-								int errorCode = WSAGetLastError();
-								if (errorCode != WSAEWOULDBLOCK)
-								{
-									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
-									return -1;
-								}
+			u_long nonBlockingMode = 1;
+			if (ioctlsocket(mSocket, FIONBIO, &nonBlockingMode) != 0)
+			{
+				mLastError = UdpClientError::FAILED_TO_SET_NONBLOCK;
+				return -1;
+			}
 #else
-								if (errno != EWOULDBLOCK)
-								{
-									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
-									return -1;
-								}
+			int flags = fcntl(mSocket, F_GETFL, 0);
+			if (flags == -1)
+			{
+				mLastError = UdpClientError::FAILED_TO_GET_SOCKET_FLAGS;
+				return -1;
+			}
+
+			if (fcntl(mSocket, F_SETFL, flags | O_NONBLOCK) == -1)
+			{
+				mLastError = UdpClientError::FAILED_TO_SET_NONBLOCK;
+				return -1;
+			}
 #endif
-								return 0;
-							}
+			// Set reuseable address. 
+			int opt = 1;
+			if (setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt)) < 0)
+			{
+				mLastError = UdpClientError::ENABLE_REUSEADDR_FAILED;
+				return -1;
+			}
 
-							mLastRecvBroadcastPort = ntohs(addr.sin_port);
-							return receivedBytes;
-						}
+			// Filter and size before binding so nothing is ever queued without them.
+			if (ApplySocketOptions(mSocket, SendType::UNICAST) < 0)
+			{
+				return -1;
+			}
 
-						// If here, selectResult == 0, so we check next socket. 
-					}
-				}
+			if (bind(mSocket,(sockaddr*)&mClientAddr, sizeof(mClientAddr)) < 0)
+			{
+				mLastError = UdpClientError::BIND_FAILED;
+				return -1;
+			}
 
-				// If here, for loop completed, and all have no data. 
-				return 0;
+			if (mReceiveCoalescing && SetReceiveCoalescing(true) < 0)
+			{
+				return -1;
 			}
-			return -1;
-		}
 
-		int8_t UDP_Client::ReceiveBroadcast(void* buffer, const uint32_t maxSize, int16_t& port)
-		{
-			int rtn = ReceiveBroadcast(buffer, maxSize);
+			if (mZeroCopy && ConfigureZeroCopy(mSocket, true) < 0)
+			{
+				return -1;
+			}
 
-			if (rtn >= 0)
+			if (mUring != nullptr && mUring->ArmReceive(mSocket, SendType::UNICAST) < 0)
 			{
-				port = mLastRecvBroadcastPort;
+				mLastError = UdpClientError::READ_FAILED;
+				return -1;
 			}
-			return rtn;
+
+			return 0;
 		}
 
-		int8_t UDP_Client::ReceiveBroadcastFromListenerPort(void* buffer, const uint32_t maxSize, const int16_t port)
+		int8_t UDP_Client::Send(const char* buffer, const uint32_t size, const SendType type)
 		{
-			if (mBroadcastListeners.size() > 0)
+			switch (type)
 			{
-				for (const auto& i : mBroadcastListeners)
-				{
-					// Grab the socket and addr info from the vector for use.
-					SOCKET sock = std::get<0>(i);
-					sockaddr_in addr = std::get<1>(i);
+			case SendType::UNICAST:		return SendUnicast(buffer, size);	break;
+			case SendType::BROADCAST:	return SendBroadcast(buffer, size); break;
+			case SendType::MULTICAST:	return SendMulticast(buffer, size); break;
+			default: return -1;
+			}
+
+			// default return
+			return -1;
+		}
+
+		int8_t UDP_Client::SendUnicast(const char* buffer, const uint32_t size)
+		{
+			// verify socket and then send datagram
+			if (mSocket != INVALID_SOCKET)
+			{
+				if (mSendQueueEnabled)
+				{
+					std::span<const char> piece(buffer, size);
+					return static_cast<int8_t>(SendOrQueue(GatherBuffers(&piece, 1), mDestinationAddr));
+				}
+
+				// A pinned socket already knows its peer and route.
+				int32_t numSent = mPeerPinned
+					? send(mSocket, buffer, size, 0)
+					: SendTo(mSocket, buffer, size, mDestinationAddr);
+
+				if (numSent == -1)
+				{
+					mLastError = UdpClientError::SEND_FAILED;
+					return -1;
+				}
+
+				// return success
+				return numSent;
+			}
+
+			// default return
+			return -1;
+		}
+
+		int8_t UDP_Client::SendUnicast(const char* buffer, const uint32_t size, const std::string& ipAddress, const int16_t port)
+		{
+			// verify socket and then send datagram
+			if (mSocket != INVALID_SOCKET)
+			{
+				// Resolving checks the address and port and sets the error.
+				Destination destination;
+				if (ResolveDestination(ipAddress, port, destination) == -1)
+				{
+					return -1;
+				}
+
+				return static_cast<int8_t>(SendUnicast(buffer, size, destination));
+			}
+
+			// default return
+			return -1;
+		}
+
+		int32_t UDP_Client::SendUnicast(const char* buffer, const uint32_t size, const Destination& destination)
+		{
+			// verify socket and destination
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			if (!destination.IsResolved())
+			{
+				mLastError = UdpClientError::SET_DESTINATION_FAILED;
+				return -1;
+			}
+
+			if (mSendQueueEnabled)
+			{
+				std::span<const char> piece(buffer, size);
+				return SendOrQueue(GatherBuffers(&piece, 1), destination.address);
+			}
+
+			int32_t numSent = SendTo(mSocket, buffer, size, destination.address);
+
+			if (numSent == -1)
+			{
+				mLastError = UdpClientError::SEND_FAILED;
+				return -1;
+			}
+
+			// return success
+			return numSent;
+		}
+
+		int32_t UDP_Client::SendUnicast(GatherBuffers buffers)
+		{
+			// verify socket
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			if (mSendQueueEnabled)
+			{
+				return SendOrQueue(buffers, mDestinationAddr);
+			}
+
+			// A pinned socket already knows its peer.
+			int32_t numSent = mPeerPinned ? SendGather(mSocket, buffers, nullptr, 0)
+				: SendGather(mSocket, buffers, (const sockaddr*)&mDestinationAddr, sizeof(mDestinationAddr));
+
+			if (numSent == -1)
+			{
+				mLastError = UdpClientError::SEND_FAILED;
+				return -1;
+			}
+
+			// return success
+			return numSent;
+		}
+
+		int32_t UDP_Client::SendUnicast(GatherBuffers buffers, const Destination& destination)
+		{
+			// verify socket and destination
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			if (!destination.IsResolved())
+			{
+				mLastError = UdpClientError::SET_DESTINATION_FAILED;
+				return -1;
+			}
+
+			if (mSendQueueEnabled)
+			{
+				return SendOrQueue(buffers, destination.address);
+			}
+
+			int32_t numSent = SendGather(mSocket, buffers, (const sockaddr*)&destination.address, sizeof(destination.address));
+
+			if (numSent == -1)
+			{
+				mLastError = UdpClientError::SEND_FAILED;
+				return -1;
+			}
+
+			// return success
+			return numSent;
+		}
+
+		int32_t UDP_Client::SendUnicastAt(const char* buffer, const uint32_t size, const Destination& destination, const uint64_t departure)
+		{
+			// verify socket and destination
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			if (!destination.IsResolved())
+			{
+				mLastError = UdpClientError::SET_DESTINATION_FAILED;
+				return -1;
+			}
+
+			// A departure time cannot wait in the queue, queued datagrams go first.
+			std::unique_lock<std::mutex> queueLock;
+			if (HoldSendQueue(queueLock) < 0)
+			{
+				mLastError = UdpClientError::SEND_QUEUE_PENDING;
+				return -1;
+			}
+
+			int32_t numSent = SendAt(mSocket, buffer, size, (const sockaddr*)&destination.address, sizeof(destination.address), departure);
+
+			if (numSent == -1)
+			{
+				mLastError = UdpClientError::SEND_FAILED;
+				return -1;
+			}
+
+			// return success
+			return numSent;
+		}
+
+		int8_t UDP_Client::ResolveDestination(const std::string& ipAddress, const int16_t port, Destination& destination)
+		{
+			destination = {};
+
+			if (ValidatePort(port) == false)
+			{
+				mLastError = UdpClientError::BAD_PORT;
+				return -1;
+			}
+
+			// Parsed once, the result is kept for every later send.
+			if (inet_pton(AF_INET, ipAddress.c_str(), &destination.address.sin_addr) == 1)
+			{
+				destination.address.sin_family = AF_INET;
+				destination.address.sin_port = htons(port);
+				return 0;
+			}
+
+			// The unicast socket is AF_INET, an IPv6 destination could never be sent to.
+			sockaddr_in6 ipv6{};
+			if (inet_pton(AF_INET6, ipAddress.c_str(), &ipv6.sin6_addr) == 1)
+			{
+				mLastError = UdpClientError::ADDRESS_NOT_SUPPORTED;
+				return -1;
+			}
+
+			mLastError = UdpClientError::BAD_ADDRESS;
+			return -1;
+		}
+
+		int32_t UDP_Client::SendUnicastBatch(std::span<UdpSendRecord> records)
+		{
+			// verify socket
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			std::unique_lock<std::mutex> queueLock;
+			if (HoldSendQueue(queueLock) < 0)
+			{
+				mLastError = UdpClientError::SEND_QUEUE_PENDING;
+				return -1;
+			}
+
+			int32_t errorCode = 0;
+			int32_t totalSent = SendBatch(records, errorCode);
+
+			// A full send buffer only cuts the batch short, anything else stopping it is a failed send.
+#ifdef WIN32
+			bool full = errorCode == WSAEWOULDBLOCK;
+#else
+			bool full = errorCode == EWOULDBLOCK;
+#endif
+			if (!full && static_cast<size_t>(std::max(totalSent, 0)) < records.size())
+			{
+				mLastError = UdpClientError::SEND_FAILED;
+			}
+
+			return totalSent;
+		}
+
+		int32_t UDP_Client::SendUnicastBatch(std::span<UdpSendRecord> records, int32_t& errorCode)
+		{
+			// Queued datagrams go first, until they have the batch waits like it would for a full send buffer.
+			std::unique_lock<std::mutex> queueLock;
+			if (HoldSendQueue(queueLock) < 0)
+			{
+				for (auto& record : records)
+				{
+					record.result = -1;
+				}
+
+#ifdef WIN32
+				errorCode = WSAEWOULDBLOCK;
+#else
+				errorCode = EWOULDBLOCK;
+#endif
+				return 0;
+			}
+
+			return SendBatch(records, errorCode);
+		}
+
+		int32_t UDP_Client::SendBatch(std::span<UdpSendRecord> records, int32_t& errorCode)
+		{
+			errorCode = 0;
+
+			// verify socket
+			if (mSocket == INVALID_SOCKET)
+			{
+#ifdef WIN32
+				errorCode = WSAENOTSOCK;
+#else
+				errorCode = EBADF;
+#endif
+				return -1;
+			}
+
+			for (auto& record : records)
+			{
+				record.result = -1;
+			}
+
+			int32_t totalSent = 0;
+
+#if defined __linux__
+			// Flush the records in chunks, each chunk is a single sendmmsg call.
+			mmsghdr messages[UDP_MAX_BATCH_SIZE];
+			iovec	vectors[UDP_MAX_BATCH_SIZE];
+
+			for (size_t offset = 0; offset < records.size(); offset += UDP_MAX_BATCH_SIZE)
+			{
+				size_t count = std::min<size_t>(UDP_MAX_BATCH_SIZE, records.size() - offset);
+
+				for (size_t i = 0; i < count; i++)
+				{
+					UdpSendRecord& record = records[offset + i];
+					const sockaddr_in* destination = record.destination != nullptr ? record.destination : &mDestinationAddr;
+
+					vectors[i].iov_base = const_cast<char*>(record.buffer);
+					vectors[i].iov_len = record.size;
+
+					messages[i] = {};
+					messages[i].msg_hdr.msg_name = const_cast<sockaddr_in*>(destination);
+					messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+					messages[i].msg_hdr.msg_iov = &vectors[i];
+					messages[i].msg_hdr.msg_iovlen = 1;
+				}
+
+				int numSent = sendmmsg(mSocket, messages, static_cast<unsigned int>(count), 0);
+
+				if (numSent == -1)
+				{
+					errorCode = errno;
+
+					// Socket buffer is full, report what has been sent so far.
+					if (errno == EWOULDBLOCK)
+					{
+						return totalSent;
+					}
+
+					return totalSent > 0 ? totalSent : -1;
+				}
+
+				for (int i = 0; i < numSent; i++)
+				{
+					records[offset + i].result = static_cast<int32_t>(messages[i].msg_len);
+				}
+
+				totalSent += numSent;
+
+				// The kernel stops at the first datagram it could not send and keeps the reason, a retry from there reports it.
+				if (static_cast<size_t>(numSent) < count)
+				{
+					return totalSent;
+				}
+			}
+#else
+			// No batched send available, fall back to one sendto per record.
+			for (auto& record : records)
+			{
+				const sockaddr_in* destination = record.destination != nullptr ? record.destination : &mDestinationAddr;
+
+				int32_t numSent = sendto(mSocket, record.buffer, record.size, 0, (const sockaddr*)destination, sizeof(sockaddr_in));
+
+				if (numSent == -1)
+				{
+					errorCode = WSAGetLastError();
+
+					// Socket buffer is full, report what has been sent so far, same as sendmmsg.
+					if (errorCode == WSAEWOULDBLOCK)
+					{
+						return totalSent;
+					}
+
+					return totalSent > 0 ? totalSent : -1;
+				}
+
+				record.result = numSent;
+				totalSent++;
+			}
+#endif
+
+			return totalSent;
+		}
+
+		int32_t UDP_Client::SendUnicastSegmented(const char* buffer, const uint32_t size, const uint16_t segmentSize, const sockaddr_in* destination)
+		{
+			// verify socket
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			// A segment must fit one datagram, so the kernel never refuses a send for its size alone.
+			if (segmentSize == 0 || segmentSize > UDP_MAX_GSO_PAYLOAD)
+			{
+				mLastError = UdpClientError::SEND_FAILED;
+				return -1;
+			}
+
+			std::unique_lock<std::mutex> queueLock;
+			if (HoldSendQueue(queueLock) < 0)
+			{
+				mLastError = UdpClientError::SEND_QUEUE_PENDING;
+				return -1;
+			}
+
+			const sockaddr_in* target = destination != nullptr ? destination : &mDestinationAddr;
+			uint32_t offset = 0;
+
+#if defined __linux__
+			// Largest run of whole segments the kernel accepts in one send.
+			uint32_t maxChunk = std::min(UDP_MAX_GSO_SEGMENTS * segmentSize, (UDP_MAX_GSO_PAYLOAD / segmentSize) * segmentSize);
+
+			while (mSegmentOffload && maxChunk > 0 && size - offset > segmentSize)
+			{
+				uint32_t chunk = std::min(maxChunk, size - offset);
+
+				iovec vector{ const_cast<char*>(buffer + offset), chunk };
+				char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+
+				msghdr header{};
+				header.msg_name = const_cast<sockaddr_in*>(target);
+				header.msg_namelen = sizeof(sockaddr_in);
+				header.msg_iov = &vector;
+				header.msg_iovlen = 1;
+				header.msg_control = control;
+				header.msg_controllen = sizeof(control);
+
+				cmsghdr* message = CMSG_FIRSTHDR(&header);
+				message->cmsg_level = SOL_UDP;
+				message->cmsg_type = UDP_SEGMENT;
+				message->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+				memcpy(CMSG_DATA(message), &segmentSize, sizeof(uint16_t));
+
+				ssize_t numSent = sendmsg(mSocket, &header, 0);
+
+				if (numSent == -1)
+				{
+					// Kernel or device without segmentation offload, stop trying and send the rest one segment at a time.
+					if (errno == EIO || errno == ENOPROTOOPT || errno == EOPNOTSUPP)
+					{
+						mSegmentOffload = false;
+						break;
+					}
+
+					// Refused for this send only, such as a segment past the route MTU, the rest goes out one segment at a time.
+					if (errno == EINVAL)
+					{
+						break;
+					}
+
+					if (errno == EWOULDBLOCK)
+					{
+						return static_cast<int32_t>(offset);
+					}
+
+					mLastError = UdpClientError::SEND_FAILED;
+					return offset > 0 ? static_cast<int32_t>(offset) : -1;
+				}
+
+				offset += static_cast<uint32_t>(numSent);
+			}
+#endif
+
+			// Send what is left as individual datagrams, a batch at a time.
+			UdpSendRecord records[UDP_MAX_BATCH_SIZE];
+
+			while (offset < size)
+			{
+				uint32_t count = 0;
+				uint32_t batchOffset = offset;
+
+				while (count < UDP_MAX_BATCH_SIZE && batchOffset < size)
+				{
+					records[count].buffer = buffer + batchOffset;
+					records[count].size = std::min<uint32_t>(segmentSize, size - batchOffset);
+					records[count].destination = target;
+					batchOffset += records[count].size;
+					count++;
+				}
+
+				int32_t errorCode = 0;
+				int32_t numSent = SendBatch(std::span<UdpSendRecord>(records, count), errorCode);
+
+				if (numSent < 0)
+				{
+					mLastError = UdpClientError::SEND_FAILED;
+					return offset > 0 ? static_cast<int32_t>(offset) : -1;
+				}
+
+				for (int32_t i = 0; i < numSent; i++)
+				{
+					offset += records[i].size;
+				}
+
+				if (static_cast<uint32_t>(numSent) < count)
+				{
+					break;
+				}
+			}
+
+			return static_cast<int32_t>(offset);
+		}
+
+		int8_t UDP_Client::EnableZeroCopy(const bool enable)
+		{
+#if defined __linux__
+			if (mSocket != INVALID_SOCKET && ConfigureZeroCopy(mSocket, enable) < 0)
+			{
+				return -1;
+			}
+
+			for (const auto& i : mMulticastSockets)
+			{
+				if (ConfigureZeroCopy(std::get<0>(i), enable) < 0)
+				{
+					return -1;
+				}
+			}
+
+			mZeroCopy = enable;
+			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
+			return -1;
+#endif
+		}
+
+		int32_t UDP_Client::SendUnicastZeroCopy(const char* buffer, const uint32_t size, ZeroCopyHandle& handle, const sockaddr_in* destination)
+		{
+			// verify socket and then send datagram
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			std::unique_lock<std::mutex> queueLock;
+			if (HoldSendQueue(queueLock) < 0)
+			{
+				mLastError = UdpClientError::SEND_QUEUE_PENDING;
+				return -1;
+			}
+
+			int32_t numSent = SendZeroCopy(mSocket, buffer, size, destination != nullptr ? *destination : mDestinationAddr, handle);
+
+			if (numSent == -1)
+			{
+				mLastError = UdpClientError::SEND_FAILED;
+			}
+
+			return numSent;
+		}
+
+		int32_t UDP_Client::SendMulticastZeroCopy(const char* buffer, const uint32_t size, const std::string& groupIP, ZeroCopyHandle& handle)
+		{
+			in_addr group{};
+			auto found = (inet_pton(AF_INET, groupIP.c_str(), &group) == 1) ? mMulticastGroupIndex.find(group.s_addr) : mMulticastGroupIndex.end();
+
+			if (found != mMulticastGroupIndex.end() && !found->second.empty())
+			{
+				const auto& i = mMulticastSockets[found->second.front()];
+				int32_t numSent = SendZeroCopy(std::get<0>(i), buffer, size, std::get<1>(i), handle);
+
+				if (numSent == -1)
+				{
+					mLastError = UdpClientError::SEND_MULTICAST_FAILED;
+				}
+
+				return numSent;
+			}
+
+			mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
+			return -1;
+		}
+
+		void UDP_Client::SetZeroCopyCallback(ZeroCopyCallback callback)
+		{
+			mZeroCopyCallback = std::move(callback);
+		}
+
+		int32_t UDP_Client::PollZeroCopyCompletions()
+		{
+			int32_t totalCompleted = 0;
+
+#if defined __linux__
+			for (auto& [sock, state] : mZeroCopyStates)
+			{
+				for (;;)
+				{
+					char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in))] = {};
+
+					msghdr header{};
+					header.msg_control = control;
+					header.msg_controllen = sizeof(control);
+
+					if (recvmsg(sock, &header, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+					{
+						if (errno != EWOULDBLOCK)
+						{
+							mLastError = UdpClientError::READ_FAILED;
+							return -1;
+						}
+						break;
+					}
+
+					for (cmsghdr* message = CMSG_FIRSTHDR(&header); message != nullptr; message = CMSG_NXTHDR(&header, message))
+					{
+						if (message->cmsg_level != SOL_IP || message->cmsg_type != IP_RECVERR)
+						{
+							continue;
+						}
+
+						sock_extended_err error{};
+						memcpy(&error, CMSG_DATA(message), sizeof(error));
+
+						if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+						{
+							continue;
+						}
+
+						// The kernel reports an inclusive run of sequences.
+						ZeroCopyCompletion completion{};
+						completion.socket = sock;
+						completion.first = error.ee_info;
+						completion.last = error.ee_data;
+						completion.copied = (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+
+						if (completion.first == state.released)
+						{
+							state.released = completion.last + 1;
+						}
+						else
+						{
+							state.pending.push_back({ completion.first, completion.last });
+						}
+
+						// Join any runs that completed out of order.
+						bool joined = true;
+						while (joined && !state.pending.empty())
+						{
+							joined = false;
+							for (size_t j = 0; j < state.pending.size(); j++)
+							{
+								if (state.pending[j].first == state.released)
+								{
+									state.released = state.pending[j].second + 1;
+									state.pending.erase(state.pending.begin() + j);
+									joined = true;
+									break;
+								}
+							}
+						}
+
+						totalCompleted += static_cast<int32_t>(completion.last - completion.first + 1);
+
+						if (mZeroCopyCallback)
+						{
+							mZeroCopyCallback(completion);
+						}
+					}
+				}
+			}
+#endif
+
+			return totalCompleted;
+		}
+
+		bool UDP_Client::IsBufferReleased(const ZeroCopyHandle& handle)
+		{
+			auto state = mZeroCopyStates.find(handle.socket);
+
+			// Socket closed or never used for zero-copy, nothing can still reference the buffer.
+			if (state == mZeroCopyStates.end())
+			{
+				return true;
+			}
+
+			if (static_cast<int32_t>(handle.sequence - state->second.released) < 0)
+			{
+				return true;
+			}
+
+			for (const auto& run : state->second.pending)
+			{
+				if (static_cast<int32_t>(handle.sequence - run.first) >= 0 && static_cast<int32_t>(run.second - handle.sequence) >= 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		int8_t UDP_Client::EnableSendQueue(const uint32_t slotCount, const uint32_t slotSize, const uint32_t highWaterMark)
+		{
+			// The event loop is opened here rather than on the sending path, PollListeners drains the queue through it.
+			if (slotCount > 0 && OpenListenerPoll() < 0)
+			{
+				return -1;
+			}
+
+			std::lock_guard<std::mutex> lock(mSendQueueLock);
+
+			if (mSendQueue != nullptr)
+			{
+				WatchSendQueue(false);
+				mSendQueueEnabled = false;
+				delete mSendQueue;
+				mSendQueue = nullptr;
+			}
+
+			mSendQueueAboveHighWater = false;
+			mSendQueueDrops = 0;
+
+			if (slotCount == 0)
+			{
+				return 0;
+			}
+
+			mSendQueue = new UDP_PacketRing(slotCount, slotSize);
+			mSendQueueEnabled = true;
+
+			uint32_t capacity = mSendQueue->Capacity();
+			mSendQueueHighWater = highWaterMark > 0 ? std::min(highWaterMark, capacity) : std::max<uint32_t>(capacity / 4 * 3, 1);
+
+			return 0;
+		}
+
+		void UDP_Client::SetSendQueueCallback(SendQueueCallback callback)
+		{
+			std::lock_guard<std::mutex> lock(mSendQueueLock);
+			mSendQueueCallback = callback;
+		}
+
+		uint32_t UDP_Client::GetSendQueueDepth()
+		{
+			std::lock_guard<std::mutex> lock(mSendQueueLock);
+			return mSendQueue != nullptr ? mSendQueue->Depth() : 0;
+		}
+
+		uint64_t UDP_Client::GetSendQueueDropCount()
+		{
+			std::lock_guard<std::mutex> lock(mSendQueueLock);
+			return mSendQueueDrops;
+		}
+
+		uint32_t UDP_Client::GetSendQueueCapacity()
+		{
+			std::lock_guard<std::mutex> lock(mSendQueueLock);
+			return mSendQueue != nullptr ? mSendQueue->Capacity() : 0;
+		}
+
+		int32_t UDP_Client::PollSendQueue(const int32_t timeoutMSecs)
+		{
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			if (GetSendQueueDepth() == 0)
+			{
+				return 0;
+			}
+
+			// Wait for room in the socket buffer, the same readiness epoll reports as EPOLLOUT.
+#ifdef WIN32
+			WSAPOLLFD descriptor{};
+			descriptor.fd = mSocket;
+			descriptor.events = POLLWRNORM;
+			int ready = WSAPoll(&descriptor, 1, timeoutMSecs);
+#else
+			pollfd descriptor{};
+			descriptor.fd = mSocket;
+			descriptor.events = POLLOUT;
+			int ready = poll(&descriptor, 1, timeoutMSecs);
+#endif
+
+			if (ready == SOCKET_ERROR)
+			{
+#ifdef WIN32
+				if (WSAGetLastError() == WSAEINTR)
+#else
+				if (errno == EINTR)
+#endif
+				{
+					return 0;
+				}
+
+				mLastError = UdpClientError::SEND_FAILED;
+				return -1;
+			}
+
+			if (ready == 0)
+			{
+				return 0;
+			}
+
+			return FlushSendQueue();
+		}
+
+		int8_t UDP_Client::SendBroadcast(const char* buffer, const uint32_t size)
+		{
+			// verify socket and then send datagram
+			if (mBroadcastSocket != INVALID_SOCKET)
+			{
+				int32_t numSent = SendTo(mBroadcastSocket, buffer, size, mBroadcastAddr);
+
+				if (numSent == -1)
+				{
+					mLastError = UdpClientError::SEND_BROADCAST_FAILED;
+					return -1;
+				}
+
+				// return success
+				return numSent;
+			}
+
+			// default return
+			return -1;
+		}
+
+		int32_t UDP_Client::SendBroadcast(GatherBuffers buffers)
+		{
+			// verify socket and then send datagram
+			if (mBroadcastSocket != INVALID_SOCKET)
+			{
+				int32_t numSent = SendGather(mBroadcastSocket, buffers, (const sockaddr*)&mBroadcastAddr, sizeof(mBroadcastAddr));
+
+				if (numSent == -1)
+				{
+					mLastError = UdpClientError::SEND_BROADCAST_FAILED;
+					return -1;
+				}
+
+				// return success
+				return numSent;
+			}
+
+			// default return
+			return -1;
+		}
+
+		int8_t UDP_Client::SendMulticast(const char* buffer, const uint32_t size, const std::string& groupIP)
+		{
+			// verify socket and then send datagram
+			if (mMulticastSockets.size() > 0)
+			{
+				int32_t numSent = 0;
+
+				if (groupIP.empty())
+				{
+					for (const auto& i : mMulticastSockets)
+					{
+						numSent = SendTo(std::get<0>(i), buffer, size, std::get<1>(i));
+
+						if (numSent < 0)
+						{
+							mLastError = UdpClientError::SEND_MULTICAST_FAILED;
+							return -1;
+						}
+					}
+
+					return numSent;
+				}
+
+				// Only send to the desired group, on every port it was joined on.
+				in_addr group{};
+				if (inet_pton(AF_INET, groupIP.c_str(), &group) != 1)
+				{
+					mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
+					return -1;
+				}
+
+				auto found = mMulticastGroupIndex.find(group.s_addr);
+				if (found == mMulticastGroupIndex.end())
+				{
+					return 0;
+				}
+
+				for (size_t index : found->second)
+				{
+					numSent = SendMulticastToGroup(buffer, size, static_cast<MulticastGroupId>(index));
+
+					if (numSent < 0)
+					{
+						return -1;
+					}
+				}
+
+				return numSent;
+			}
+
+			return -1;
+		}
+
+		int32_t UDP_Client::SendMulticast(GatherBuffers buffers, const std::string& groupIP)
+		{
+			// verify socket and then send datagram
+			if (mMulticastSockets.size() < 1)
+			{
+				return -1;
+			}
+
+			int32_t numSent = 0;
+
+			if (groupIP.empty())
+			{
+				for (MulticastGroupId id = 0; id < mMulticastSockets.size(); id++)
+				{
+					numSent = SendMulticastToGroup(buffers, id);
+
+					if (numSent < 0)
+					{
+						return -1;
+					}
+				}
+
+				return numSent;
+			}
+
+			// Only send to the desired group, on every port it was joined on.
+			in_addr group{};
+			if (inet_pton(AF_INET, groupIP.c_str(), &group) != 1)
+			{
+				mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
+				return -1;
+			}
+
+			auto found = mMulticastGroupIndex.find(group.s_addr);
+			if (found == mMulticastGroupIndex.end())
+			{
+				return 0;
+			}
+
+			for (size_t index : found->second)
+			{
+				numSent = SendMulticastToGroup(buffers, static_cast<MulticastGroupId>(index));
+
+				if (numSent < 0)
+				{
+					return -1;
+				}
+			}
+
+			return numSent;
+		}
+
+		int32_t UDP_Client::SendMulticastToGroup(GatherBuffers buffers, const MulticastGroupId id)
+		{
+			if (id >= mMulticastSockets.size())
+			{
+				mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
+				return -1;
+			}
+
+			const auto& group = mMulticastSockets[id];
+			int32_t numSent = SendGather(std::get<0>(group), buffers, (const sockaddr*)&std::get<1>(group), sizeof(sockaddr_in));
+
+			if (numSent < 0)
+			{
+				mLastError = UdpClientError::SEND_MULTICAST_FAILED;
+				return -1;
+			}
+
+			return numSent;
+		}
+
+		int32_t UDP_Client::SendMulticastToGroup(const char* buffer, const uint32_t size, const MulticastGroupId id)
+		{
+			if (id >= mMulticastSockets.size())
+			{
+				mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
+				return -1;
+			}
+
+			const auto& group = mMulticastSockets[id];
+			int32_t numSent = SendTo(std::get<0>(group), buffer, size, std::get<1>(group));
+
+			if (numSent < 0)
+			{
+				mLastError = UdpClientError::SEND_MULTICAST_FAILED;
+				return -1;
+			}
+
+			return numSent;
+		}
+
+		int32_t UDP_Client::SendMulticastToGroupAt(const char* buffer, const uint32_t size, const MulticastGroupId id, const uint64_t departure)
+		{
+			if (id >= mMulticastSockets.size())
+			{
+				mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
+				return -1;
+			}
+
+			const auto& group = mMulticastSockets[id];
+			int32_t numSent = SendAt(std::get<0>(group), buffer, size, (const sockaddr*)&std::get<1>(group), sizeof(sockaddr_in), departure);
+
+			if (numSent < 0)
+			{
+				mLastError = UdpClientError::SEND_MULTICAST_FAILED;
+				return -1;
+			}
+
+			return numSent;
+		}
+
+		int8_t UDP_Client::GetMulticastGroupId(const std::string& groupIP, const int16_t port, MulticastGroupId& id)
+		{
+			in_addr group{};
+			if (inet_pton(AF_INET, groupIP.c_str(), &group) != 1)
+			{
+				mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
+				return -1;
+			}
+
+			size_t index = LookupMulticastGroup(group, htons(port));
+			if (index >= mMulticastSockets.size())
+			{
+				mLastError = UdpClientError::MULTICAST_NOT_ENABLED;
+				return -1;
+			}
+
+			id = static_cast<MulticastGroupId>(index);
+			return 0;
+		}
+
+		int8_t UDP_Client::ReceiveUnicast(void* buffer, const uint32_t maxSize)
+		{
+			// Store the data source info
+			sockaddr_in sourceAddress{};
+			int addressLength = sizeof(sourceAddress);
+
+			// A pinned socket only receives from its peer, recorded when it was pinned.
+			if (mPeerPinned)
+			{
+#if defined WIN32
+				int32_t sizeRead = recv(mSocket, reinterpret_cast<char*>(buffer), maxSize - 1, 0);
+				if (sizeRead == -1 && WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+				int32_t sizeRead = recv(mSocket, buffer, static_cast<size_t>(maxSize) - 1, 0);
+				if (sizeRead == -1 && errno == EWOULDBLOCK)
+#endif
+				{
+					return 0;
+				}
+
+				if (sizeRead == -1)
+				{
+					mLastError = UdpClientError::READ_FAILED;
+				}
+
+				return sizeRead;
+			}
+
+			// Receive datagram over UDP
+#if defined WIN32
+			int32_t sizeRead = recvfrom(mSocket, reinterpret_cast<char*>(buffer), maxSize-1, 0, (sockaddr*)&sourceAddress, &addressLength);
+#else
+			int32_t sizeRead = recvfrom(mSocket, buffer, static_cast<size_t>(maxSize) - 1, 0, (sockaddr*)&sourceAddress, reinterpret_cast<socklen_t*>(&addressLength));
+#endif
+
+			// Check for error
+			if (sizeRead == -1)
+			{
+#ifdef WIN32
+				int errorCode = WSAGetLastError();
+				if (errorCode != WSAEWOULDBLOCK)
+				{
+					mLastError = UdpClientError::READ_FAILED;
+					return -1;
+				}
+#else
+				if (errno != EWOULDBLOCK)
+				{
+					mLastError = UdpClientError::READ_FAILED;
+					return -1;
+				}
+#endif
+				return 0;
+			}
+
+			// if data was received, store the port and ip for history. 
+			if (sizeRead > 0)
+			{
+				mLastReceiveInfo->port = ntohs(sourceAddress.sin_port);
+
+				char addr[INET_ADDRSTRLEN];
+				if (inet_ntop(AF_INET, &(sourceAddress.sin_addr), addr, INET_ADDRSTRLEN) != NULL)
+				{
+					mLastReceiveInfo->ipAddress = addr;
+				}
+			}
+
+			// return size read
+			return sizeRead;
+		}
+
+		int8_t UDP_Client::ReceiveUnicast(void* buffer, const uint32_t maxSize, std::string& recvFromAddr, int16_t& recvFromPort)
+		{
+			int8_t rtn = ReceiveUnicast(buffer, maxSize);
+
+			if (rtn > 0)
+			{
+				recvFromAddr = GetIpOfLastReceive();
+				recvFromPort = GetPortOfLastReceive();
+			}
+
+			return rtn;;
+		}
+
+		int32_t UDP_Client::ReceiveUnicastCoalesced(void* buffer, const uint32_t maxSize, CoalescedDatagrams& datagrams)
+		{
+			// verify socket
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			datagrams = {};
+			datagrams.data = reinterpret_cast<const char*>(buffer);
+
+#if defined __linux__
+			iovec vector{ buffer, maxSize };
+			char control[CMSG_SPACE(sizeof(int)) + UDP_RECEIVE_CONTROL_SIZE] = {};
+
+			msghdr header{};
+			header.msg_name = &datagrams.source;
+			header.msg_namelen = sizeof(datagrams.source);
+			header.msg_iov = &vector;
+			header.msg_iovlen = 1;
+			header.msg_control = control;
+			header.msg_controllen = sizeof(control);
+
+			ssize_t sizeRead = recvmsg(mSocket, &header, MSG_DONTWAIT);
+#else
+			int addressLength = sizeof(datagrams.source);
+			int32_t sizeRead = recvfrom(mSocket, reinterpret_cast<char*>(buffer), maxSize, 0, (sockaddr*)&datagrams.source, &addressLength);
+#endif
+
+			// Check for error
+			if (sizeRead == -1)
+			{
+#ifdef WIN32
+				int errorCode = WSAGetLastError();
+				if (errorCode == WSAEMSGSIZE)
+				{
+					datagrams.size = maxSize;
+					datagrams.truncated = true;
+					return static_cast<int32_t>(maxSize);
+				}
+
+				if (errorCode != WSAEWOULDBLOCK)
+#else
+				if (errno != EWOULDBLOCK)
+#endif
+				{
+					mLastError = UdpClientError::READ_FAILED;
+					return -1;
+				}
+				return 0;
+			}
+
+			datagrams.size = static_cast<uint32_t>(sizeRead);
+
+#if defined __linux__
+			datagrams.truncated = (header.msg_flags & MSG_TRUNC) != 0;
+
+			// Without the segment size the run would read as one datagram.
+			if ((header.msg_flags & MSG_CTRUNC) != 0)
+			{
+				mLastError = UdpClientError::READ_FAILED;
+				return -1;
+			}
+
+			// The kernel reports the size of each coalesced datagram alongside the buffer.
+			for (cmsghdr* message = CMSG_FIRSTHDR(&header); message != nullptr; message = CMSG_NXTHDR(&header, message))
+			{
+				if (message->cmsg_level == SOL_UDP && message->cmsg_type == UDP_GRO)
+				{
+					int segmentSize = 0;
+					memcpy(&segmentSize, CMSG_DATA(message), sizeof(segmentSize));
+					datagrams.segmentSize = static_cast<uint16_t>(segmentSize);
+				}
+				else if (ReadDropCount(message, mSocket, datagrams.drops))
+				{
+					mKernelDrops = datagrams.drops;
+				}
+				else
+				{
+					uint64_t hardwareTimestamp = 0;
+					ReadTimestamp(message, datagrams.timestamp, hardwareTimestamp);
+				}
+			}
+#endif
+
+			return static_cast<int32_t>(sizeRead);
+		}
+
+		int32_t UDP_Client::ReceiveUnicastBatch(std::span<UdpReceiveSlot> slots)
+		{
+			// verify socket
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			int32_t totalReceived = 0;
+
+#if defined __linux__
+			// Fill the slots in chunks, each chunk is a single recvmmsg call.
+			mmsghdr messages[UDP_MAX_BATCH_SIZE];
+			iovec	vectors[UDP_MAX_BATCH_SIZE];
+			char	controls[UDP_MAX_BATCH_SIZE][UDP_RECEIVE_CONTROL_SIZE];
+
+			for (size_t offset = 0; offset < slots.size(); offset += UDP_MAX_BATCH_SIZE)
+			{
+				size_t count = std::min<size_t>(UDP_MAX_BATCH_SIZE, slots.size() - offset);
+
+				for (size_t i = 0; i < count; i++)
+				{
+					UdpReceiveSlot& slot = slots[offset + i];
+
+					vectors[i].iov_base = slot.buffer;
+					vectors[i].iov_len = slot.maxSize;
+
+					messages[i] = {};
+					messages[i].msg_hdr.msg_name = &slot.source;
+					messages[i].msg_hdr.msg_namelen = sizeof(slot.source);
+					messages[i].msg_hdr.msg_iov = &vectors[i];
+					messages[i].msg_hdr.msg_iovlen = 1;
+
+					if (mDropAccounting || mReceiveTimestamps)
+					{
+						messages[i].msg_hdr.msg_control = controls[i];
+						messages[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+					}
+				}
+
+				int numReceived = recvmmsg(mSocket, messages, static_cast<unsigned int>(count), MSG_DONTWAIT, nullptr);
+
+				if (numReceived == -1)
+				{
+					// No more data waiting, report what has been received so far.
+					if (errno == EWOULDBLOCK)
+					{
+						return totalReceived;
+					}
+
+					mLastError = UdpClientError::READ_FAILED;
+					return totalReceived > 0 ? totalReceived : -1;
+				}
+
+				for (int i = 0; i < numReceived; i++)
+				{
+					UdpReceiveSlot& slot = slots[offset + i];
+					slot.length = messages[i].msg_len;
+					slot.truncated = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+					slot.drops = 0;
+					slot.timestamp = 0;
+					slot.hardwareTimestamp = 0;
+
+					// The count only comes along once the socket has dropped something.
+					for (cmsghdr* message = CMSG_FIRSTHDR(&messages[i].msg_hdr); message != nullptr; message = CMSG_NXTHDR(&messages[i].msg_hdr, message))
+					{
+						if (ReadDropCount(message, mSocket, slot.drops))
+						{
+							mKernelDrops = slot.drops;
+						}
+						else
+						{
+							ReadTimestamp(message, slot.timestamp, slot.hardwareTimestamp);
+						}
+					}
+				}
+
+				totalReceived += numReceived;
+
+				// Queue drained before this chunk was full, no need to ask again.
+				if (static_cast<size_t>(numReceived) < count)
+				{
+					return totalReceived;
+				}
+			}
+#else
+			// No batched receive available, fall back to one recvfrom per slot.
+			for (auto& slot : slots)
+			{
+				int addressLength = sizeof(slot.source);
+				int32_t sizeRead = recvfrom(mSocket, reinterpret_cast<char*>(slot.buffer), slot.maxSize, 0, (sockaddr*)&slot.source, &addressLength);
+
+				if (sizeRead == -1)
+				{
+					int errorCode = WSAGetLastError();
+					if (errorCode == WSAEMSGSIZE)
+					{
+						slot.length = slot.maxSize;
+						slot.truncated = true;
+						totalReceived++;
+						continue;
+					}
+
+					if (errorCode != WSAEWOULDBLOCK)
+					{
+						mLastError = UdpClientError::READ_FAILED;
+						return totalReceived > 0 ? totalReceived : -1;
+					}
+
+					break;
+				}
+
+				slot.length = sizeRead;
+				slot.truncated = false;
+				totalReceived++;
+			}
+#endif
+
+			return totalReceived;
+		}
+
+		int32_t UDP_Client::ReceiveUnicast(UDP_BufferPool& pool, PacketBuffer& packet)
+		{
+			int32_t rtn = ReceiveUnicastBatch(pool, std::span<PacketBuffer>(&packet, 1));
+
+			return rtn > 0 ? static_cast<int32_t>(packet.Size()) : rtn;
+		}
+
+		int32_t UDP_Client::ReceiveUnicastBatch(UDP_BufferPool& pool, std::span<PacketBuffer> packets)
+		{
+			int32_t totalReceived = 0;
+			UdpReceiveSlot slots[UDP_MAX_BATCH_SIZE];
+
+			for (auto& packet : packets)
+			{
+				packet.Release();
+			}
+
+			for (size_t offset = 0; offset < packets.size(); offset += UDP_MAX_BATCH_SIZE)
+			{
+				size_t count = std::min<size_t>(UDP_MAX_BATCH_SIZE, packets.size() - offset);
+				bool exhausted = false;
+
+				// Take a buffer for each slot, stop short if the pool runs dry.
+				for (size_t i = 0; i < count; i++)
+				{
+					packets[offset + i] = pool.Acquire();
+
+					if (!packets[offset + i])
+					{
+						count = i;
+						exhausted = true;
+						break;
+					}
+
+					slots[i] = {};
+					slots[i].buffer = packets[offset + i].Data();
+					slots[i].maxSize = packets[offset + i].Capacity();
+				}
+
+				if (count == 0)
+				{
+					mLastError = UdpClientError::BUFFER_POOL_EXHAUSTED;
+					return totalReceived > 0 ? totalReceived : -1;
+				}
+
+				int32_t numReceived = ReceiveUnicastBatch(std::span<UdpReceiveSlot>(slots, count));
+
+				// Hand unfilled buffers straight back.
+				for (size_t i = std::max<int32_t>(numReceived, 0); i < count; i++)
+				{
+					packets[offset + i].Release();
+				}
+
+				if (numReceived == -1)
+				{
+					return totalReceived > 0 ? totalReceived : -1;
+				}
+
+				for (int32_t i = 0; i < numReceived; i++)
+				{
+					packets[offset + i].SetSize(slots[i].length);
+					packets[offset + i].Source() = slots[i].source;
+					packets[offset + i].Timestamp() = slots[i].timestamp;
+					packets[offset + i].Truncated() = slots[i].truncated;
+				}
+
+				totalReceived += numReceived;
+
+				if (exhausted || static_cast<size_t>(numReceived) < count)
+				{
+					break;
+				}
+			}
+
+			return totalReceived;
+		}
+
+		int8_t UDP_Client::SetBusyPoll(const uint32_t spinMicroseconds)
+		{
+			mBusyPollBudget = spinMicroseconds;
+
+			if (mSocket != INVALID_SOCKET)
+			{
+				ConfigureBusyPoll(mSocket);
+			}
+
+			return 0;
+		}
+
+		int32_t UDP_Client::ReceiveUnicastSpin(void* buffer, const uint32_t maxSize, const int32_t timeoutMSecs)
+		{
+			UdpReceiveSlot slot{};
+			slot.buffer = buffer;
+			slot.maxSize = maxSize;
+
+			int32_t rtn = ReceiveUnicastBatchSpin(std::span<UdpReceiveSlot>(&slot, 1), timeoutMSecs);
+
+			return rtn > 0 ? static_cast<int32_t>(slot.length) : rtn;
+		}
+
+		int32_t UDP_Client::ReceiveUnicastBatchSpin(std::span<UdpReceiveSlot> slots, const int32_t timeoutMSecs)
+		{
+			// verify socket
+			if (mSocket == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			// Spin on the non-blocking receive, the packet is picked up without a scheduler wakeup.
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(mBusyPollBudget);
+
+			for (;;)
+			{
+				int32_t numReceived = ReceiveUnicastBatch(slots);
+
+				if (numReceived != 0)
+				{
+					return numReceived;
+				}
+
+				if (std::chrono::steady_clock::now() >= deadline)
+				{
+					break;
+				}
+			}
+
+			// Spin budget spent, sleep in the kernel until something arrives.
+#ifdef WIN32
+			WSAPOLLFD descriptor{};
+			descriptor.fd = mSocket;
+			descriptor.events = POLLRDNORM;
+			int ready = WSAPoll(&descriptor, 1, timeoutMSecs);
+#else
+			pollfd descriptor{};
+			descriptor.fd = mSocket;
+			descriptor.events = POLLIN;
+			int ready = poll(&descriptor, 1, timeoutMSecs);
+#endif
+
+			if (ready == SOCKET_ERROR)
+			{
+#ifdef WIN32
+				if (WSAGetLastError() == WSAEINTR)
+#else
+				if (errno == EINTR)
+#endif
+				{
+					return 0;
+				}
+
+				mLastError = UdpClientError::SELECT_READ_ERROR;
+				return -1;
+			}
+
+			return ready > 0 ? ReceiveUnicastBatch(slots) : 0;
+		}
+
+		int8_t UDP_Client::ReceiveBroadcast(void* buffer, const uint32_t maxSize)
+		{
+			if (mBroadcastListeners.size() > 0)
+			{
+				for (const auto& i : mBroadcastListeners)
+				{
+					// Grab the socket and addr info from the vector for use.
+					SOCKET sock = std::get<0>(i);
+					sockaddr_in addr = std::get<1>(i);
+
+					if (sock != INVALID_SOCKET)
+					{
+						// Verify incoming data is available.
+						fd_set readSet{};
+						FD_ZERO(&readSet);
+						FD_SET(sock, &readSet);
+						sockaddr_in recvFrom{};
+						int recvFromSize = sizeof(recvFrom);
+						
+						int selectResult = select((int)sock + 1, &readSet, nullptr, nullptr, &mTimeout);
+						
+						// Catch error
+						if (selectResult == SOCKET_ERROR)
+						{
+							mLastError = UdpClientError::SELECT_READ_ERROR;
+							return 1;
+						}
+
+						// If data is available on this socket, attempt to read it 
+						if (selectResult > 0)
+						{
+#if defined WIN32
+							int32_t receivedBytes = recvfrom(sock, (char*)buffer, maxSize-1, 0, reinterpret_cast<sockaddr*>(&recvFrom), &recvFromSize);
+#else
+							int32_t receivedBytes = recvfrom(mSocket, buffer, static_cast<size_t>(maxSize) - 1, 0, (sockaddr*)&recvFrom, reinterpret_cast<socklen_t*>(&recvFromSize));
+#endif
+
+							if (receivedBytes == SOCKET_ERROR)
+							{
+#ifdef WIN32
+								int errorCode = WSAGetLastError();
+								if (errorCode != WSAEWOULDBLOCK)
+								{
+									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
+									return -1;
+								}
+#else
+								if (errno != EWOULDBLOCK)
+								{
+									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
+									return -1;
+								}
+#endif
+								return 0;
+							}
+
+							mLastRecvBroadcastPort = ntohs(addr.sin_port);
+							return receivedBytes;
+						}
+
+						// If here, selectResult == 0, so we check next socket. 
+					}
+				}
+
+				// If here, for loop completed, and all have no data. 
+				return 0;
+			}
+			return -1;
+		}
+
+		int8_t UDP_Client::ReceiveBroadcast(void* buffer, const uint32_t maxSize, int16_t& port)
+		{
+			int rtn = ReceiveBroadcast(buffer, maxSize);
+
+			if (rtn >= 0)
+			{
+				port = mLastRecvBroadcastPort;
+			}
+			return rtn;
+		}
+
+		int8_t UDP_Client::ReceiveBroadcastFromListenerPort(void* buffer, const uint32_t maxSize, const int16_t port)
+		{
+			if (mBroadcastListeners.size() > 0)
+			{
+				for (const auto& i : mBroadcastListeners)
+				{
+					// Grab the socket and addr info from the vector for use.
+					SOCKET sock = std::get<0>(i);
+					sockaddr_in addr = std::get<1>(i);
 					Endpoint ep = std::get<2>(i);
 
-					// If the ports arent equal, continue to next iteration.
-					if (port != ep.port)
+					// If the ports arent equal, continue to next iteration.
+					if (port != ep.port)
+					{
+						continue;
+					}
+
+					if (sock != INVALID_SOCKET)
+					{
+						// Verify incoming data is available.
+						fd_set readSet{};
+						FD_ZERO(&readSet);
+						FD_SET(sock, &readSet);
+						sockaddr_in recvFrom{};
+						int recvFromSize = sizeof(recvFrom);
+
+						int selectResult = select((int)sock + 1, &readSet, nullptr, nullptr, &mTimeout);
+
+						// Catch error
+						if (selectResult == SOCKET_ERROR)
+						{
+							mLastError = UdpClientError::SELECT_READ_ERROR;
+							return 1;
+						}
+
+						// If data is available on this socket, attempt to read it 
+						if (selectResult > 0)
+						{
+#if defined WIN32
+							int32_t receivedBytes = recvfrom(sock, (char*)buffer, maxSize - 1, 0, reinterpret_cast<sockaddr*>(&recvFrom), &recvFromSize);
+#else
+							int32_t receivedBytes = recvfrom(mSocket, buffer, static_cast<size_t>(maxSize) - 1, 0, (sockaddr*)&recvFrom, reinterpret_cast<socklen_t*>(&recvFromSize));
+#endif
+
+							if (receivedBytes == SOCKET_ERROR)
+							{
+#ifdef WIN32
+								int errorCode = WSAGetLastError();
+								if (errorCode != WSAEWOULDBLOCK)
+								{
+									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
+									return -1;
+								}
+#else
+								if (errno != EWOULDBLOCK)
+								{
+									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
+									return -1;
+								}
+#endif
+								return 0;
+							}
+
+							mLastRecvBroadcastPort = ntohs(addr.sin_port);
+							return receivedBytes;
+						}
+
+						// If here, selectResult == 0, so we check next socket. 
+					}
+				}
+
+				// If here, for loop completed, and all have no data. 
+				return 0;
+			}
+			return -1;
+		}
+
+		int8_t UDP_Client::ReceiveMulticast(void* buffer, const uint32_t maxSize, std::string& multicastGroup)
+		{
+			if (mMulticastSockets.size() > 0)
+			{
+				// Shared sockets first, each read reports its own group.
+				for (size_t i = 0; i < mSharedMulticastSockets.size(); i++)
+				{
+					sockaddr_in recvFrom{};
+					size_t group = mMulticastSockets.size();
+					uint64_t timestamp = 0;
+					int32_t receivedBytes = ReceiveShared(i, buffer, maxSize - 1, recvFrom, group, timestamp);
+
+					if (receivedBytes < 0)
+					{
+						return -1;
+					}
+
+					if (receivedBytes > 0 && group < mMulticastSockets.size())
+					{
+						char address[INET_ADDRSTRLEN];
+						if (inet_ntop(AF_INET, &(std::get<1>(mMulticastSockets[group]).sin_addr), address, INET_ADDRSTRLEN) != NULL)
+						{
+							multicastGroup = address;
+						}
+
+						return receivedBytes;
+					}
+				}
+
+				for (const auto& i : mMulticastSockets)
+				{
+					// Grab the socket and addr info from the vector for use.
+					SOCKET sock = std::get<0>(i);
+					sockaddr_in addr = std::get<1>(i);
+
+					if (sock != INVALID_SOCKET && !IsSharedMulticastSocket(sock))
+					{
+						// Verify incoming data is available.
+						fd_set readSet{};
+						FD_ZERO(&readSet);
+						FD_SET(sock, &readSet);
+						sockaddr_in recvFrom{};
+						int recvFromSize = sizeof(recvFrom);
+						timeval timeout = mTimeout;
+
+						int selectResult = select((int)sock + 1, &readSet, nullptr, nullptr, &timeout);
+
+						// Catch error
+						if (selectResult == SOCKET_ERROR)
+						{
+							mLastError = UdpClientError::SELECT_READ_ERROR;
+							return 1;
+						}
+
+						// If data is available on this socket, attempt to read it 
+						if (selectResult > 0)
+						{
+#if defined WIN32
+							int32_t receivedBytes = recvfrom(sock, (char*)buffer, maxSize - 1, 0, reinterpret_cast<sockaddr*>(&recvFrom), &recvFromSize);
+#else
+							int32_t receivedBytes = recvfrom(sock, buffer, static_cast<size_t>(maxSize) - 1, 0, (sockaddr*)&recvFrom, reinterpret_cast<socklen_t*>(&recvFromSize));
+#endif
+
+							if (receivedBytes == SOCKET_ERROR)
+							{
+#ifdef WIN32
+								int errorCode = WSAGetLastError();
+								if (errorCode != WSAEWOULDBLOCK)
+								{
+									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
+									return -1;
+								}
+#else
+								if (errno != EWOULDBLOCK)
+								{
+									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
+									return -1;
+								}
+#endif
+								return 0;
+							}
+
+							char address[INET_ADDRSTRLEN];
+							if (inet_ntop(AF_INET, &(addr.sin_addr), address, INET_ADDRSTRLEN) != NULL)
+							{
+								multicastGroup = address;
+							}
+
+							return receivedBytes;
+						}
+
+						// If here, selectResult == 0, so we check next socket. 
+					}
+				}
+
+				// If here, for loop completed, and all have no data. 
+				return 0;
+			}
+			return -1;
+		}
+
+		void UDP_Client::SetBroadcastCallback(ListenerCallback callback)
+		{
+			mBroadcastCallback = std::move(callback);
+		}
+
+		void UDP_Client::SetMulticastCallback(ListenerCallback callback)
+		{
+			mMulticastCallback = std::move(callback);
+		}
+
+		int32_t UDP_Client::PollListeners(const int32_t timeoutMSecs)
+		{
+#if defined __linux__
+			// The send queue shares the event loop, it can be drained with no listener at all.
+			if (mBroadcastListeners.size() < 1 && mMulticastSockets.size() < 1 && !mSendQueueEnabled)
+#else
+			if (mBroadcastListeners.size() < 1 && mMulticastSockets.size() < 1)
+#endif
+			{
+				return -1;
+			}
+
+			int32_t totalDispatched = 0;
+
+#if defined __linux__
+			// Every listener registered itself as it was added.
+			if (mListenerPoll == INVALID_SOCKET)
+			{
+				mLastError = UdpClientError::EVENT_LOOP_FAILED;
+				return -1;
+			}
+
+			epoll_event events[UDP_MAX_BATCH_SIZE];
+			int readyCount = epoll_wait(mListenerPoll, events, UDP_MAX_BATCH_SIZE, timeoutMSecs);
+
+			if (readyCount == -1)
+			{
+				if (errno == EINTR)
+				{
+					return 0;
+				}
+
+				mLastError = UdpClientError::EVENT_LOOP_FAILED;
+				return -1;
+			}
+
+			for (int i = 0; i < readyCount; i++)
+			{
+				// Room in the unicast socket for queued datagrams, a failed one is dropped, counted and left in GetLastError.
+				if ((events[i].data.u64 >> 32) == UDP_SEND_QUEUE_EVENT)
+				{
+					FlushSendQueue();
+					continue;
+				}
+
+				SendType type = static_cast<SendType>(events[i].data.u64 >> 32);
+				SOCKET sock = static_cast<SOCKET>(events[i].data.u64 & 0xFFFFFFFF);
+
+				// Closed by a callback earlier in this batch.
+				auto found = mListenerIndex.find(sock);
+				if (found == mListenerIndex.end())
+				{
+					continue;
+				}
+
+				int32_t dispatched = DispatchListener(type, found->second);
+
+				if (dispatched < 0)
+				{
+					return -1;
+				}
+
+				totalDispatched += dispatched;
+			}
+#else
+			// No epoll available, wait on every listener with a single select.
+			fd_set readSet{};
+			FD_ZERO(&readSet);
+			SOCKET maxSocket = 0;
+
+			for (const auto& i : mBroadcastListeners)
+			{
+				FD_SET(std::get<0>(i), &readSet);
+				maxSocket = std::max(maxSocket, std::get<0>(i));
+			}
+
+			for (const auto& i : mMulticastSockets)
+			{
+				FD_SET(std::get<0>(i), &readSet);
+				maxSocket = std::max(maxSocket, std::get<0>(i));
+			}
+
+			timeval timeout{};
+			timeout.tv_sec = timeoutMSecs / 1000;
+			timeout.tv_usec = (timeoutMSecs % 1000) * 1000;
+
+			int selectResult = select((int)maxSocket + 1, &readSet, nullptr, nullptr, timeoutMSecs < 0 ? nullptr : &timeout);
+
+			if (selectResult == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::SELECT_READ_ERROR;
+				return -1;
+			}
+
+			for (size_t i = 0; i < mBroadcastListeners.size() && selectResult > 0; i++)
+			{
+				if (FD_ISSET(std::get<0>(mBroadcastListeners[i]), &readSet))
+				{
+					int32_t dispatched = DispatchListener(SendType::BROADCAST, i);
+
+					if (dispatched < 0)
+					{
+						return -1;
+					}
+
+					totalDispatched += dispatched;
+				}
+			}
+
+			for (size_t i = 0; i < mMulticastSockets.size() && selectResult > 0; i++)
+			{
+				if (FD_ISSET(std::get<0>(mMulticastSockets[i]), &readSet))
+				{
+					int32_t dispatched = DispatchListener(SendType::MULTICAST, i);
+
+					if (dispatched < 0)
+					{
+						return -1;
+					}
+
+					totalDispatched += dispatched;
+				}
+			}
+#endif
+
+			return totalDispatched;
+		}
+
+		int32_t UDP_Client::TakePackets(std::span<UringPacket> packets, const int32_t timeoutMSecs)
+		{
+			if (mUring == nullptr)
+			{
+				mLastError = UdpClientError::IO_URING_NOT_ENABLED;
+				return -1;
+			}
+
+			int32_t taken = mUring->TakePackets(packets, timeoutMSecs);
+
+			if (taken < 0)
+			{
+				mLastError = UdpClientError::READ_FAILED;
+				return -1;
+			}
+
+			return taken;
+		}
+
+		void UDP_Client::ReleasePacket(const UringPacket& packet)
+		{
+			if (mUring != nullptr)
+			{
+				mUring->ReleasePacket(packet);
+			}
+		}
+
+		IoBackend UDP_Client::GetIoBackend()
+		{
+			return mUring != nullptr ? IoBackend::IO_URING : IoBackend::POSIX;
+		}
+
+		int8_t UDP_Client::StartReceiveThread(const uint32_t slotCount, const uint32_t slotSize)
+		{
+			if (mReceiveRing != nullptr || mUring != nullptr || slotCount == 0 || slotSize == 0)
+			{
+				mLastError = UdpClientError::RECEIVE_THREAD_FAILED;
+				return -1;
+			}
+
+			// Snapshot the sockets, the thread owns their receive side from here on.
+			std::vector<ReceiveSocket> sockets = GetReceiveSockets();
+
+			if (sockets.empty())
+			{
+				mLastError = UdpClientError::RECEIVE_THREAD_FAILED;
+				return -1;
+			}
+
+			mReceiveRing = new UDP_PacketRing(slotCount, slotSize);
+			mReceiveThreadRunning = true;
+			mReceiveThread = std::thread(&UDP_Client::ReceiveThreadLoop, this, std::move(sockets));
+
+			return 0;
+		}
+
+		void UDP_Client::StopReceiveThread()
+		{
+			PauseReceiveThread();
+
+			if (mReceiveRing != nullptr)
+			{
+				delete mReceiveRing;
+				mReceiveRing = nullptr;
+			}
+		}
+
+		UDP_PacketRing* UDP_Client::GetReceiveRing()
+		{
+			return mReceiveRing;
+		}
+
+		int8_t UDP_Client::StartShardedReceive(const uint32_t shardCount, ShardCallback callback, const ShardSteering steering, const int32_t firstCpu, const uint32_t slotSize)
+		{
+#if defined __linux__
+			if (!mShardSockets.empty() || mSocket != INVALID_SOCKET || shardCount == 0 || slotSize == 0 || !callback)
+			{
+				mLastError = UdpClientError::SHARDED_RECEIVE_FAILED;
+				return -1;
+			}
+
+			for (uint32_t shard = 0; shard < shardCount; shard++)
+			{
+				SOCKET sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+				if (sock == INVALID_SOCKET)
+				{
+					StopShardedReceive();
+					mLastError = UdpClientError::SOCKET_OPEN_FAILURE;
+					return -1;
+				}
+
+				// Shards are added to the reuseport group in bind order, which is also the index a steering program returns.
+				mShardSockets.push_back(sock);
+
+				int reusePort = 1;
+				if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &reusePort, sizeof(reusePort)) == SOCKET_ERROR)
+				{
+					StopShardedReceive();
+					mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+					return -1;
+				}
+
+				if (steering == ShardSteering::INCOMING_CPU && firstCpu >= 0)
+				{
+					int cpu = firstCpu + static_cast<int>(shard);
+					if (setsockopt(sock, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == SOCKET_ERROR)
+					{
+						StopShardedReceive();
+						mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+						return -1;
+					}
+				}
+
+				if (ApplySocketOptions(sock, SendType::UNICAST) < 0)
+				{
+					StopShardedReceive();
+					return -1;
+				}
+
+				if (bind(sock, (sockaddr*)&mClientAddr, sizeof(mClientAddr)) == SOCKET_ERROR)
+				{
+					StopShardedReceive();
+					mLastError = UdpClientError::BIND_FAILED;
+					return -1;
+				}
+			}
+
+			// Send each datagram to the shard numbered after the cpu it arrived on, so a flow stays on one core.
+			if (steering == ShardSteering::CPU_BPF)
+			{
+				uint32_t offset = firstCpu > 0 ? static_cast<uint32_t>(firstCpu) : 0;
+				sock_filter code[] =
+				{
+					{ BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+					{ BPF_ALU | BPF_SUB | BPF_K, 0, 0, offset },
+					{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, shardCount },
+					{ BPF_RET | BPF_A, 0, 0, 0 },
+				};
+
+				// Cpus below firstCpu wrap around to high values, the modulo still lands them on a shard.
+				sock_fprog program{ static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code };
+
+				if (setsockopt(mShardSockets[0], SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == SOCKET_ERROR)
+				{
+					StopShardedReceive();
+					mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+					return -1;
+				}
+			}
+
+			mShardCallback = std::move(callback);
+			mShardsRunning = true;
+
+			for (uint32_t shard = 0; shard < shardCount; shard++)
+			{
+				int32_t cpu = firstCpu >= 0 ? firstCpu + static_cast<int32_t>(shard) : -1;
+				mShardThreads.emplace_back(&UDP_Client::ShardThreadLoop, this, shard, cpu, std::min(slotSize, UDP_MAX_DATAGRAM_SIZE));
+			}
+
+			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
+			return -1;
+#endif
+		}
+
+		void UDP_Client::StopShardedReceive()
+		{
+			mShardsRunning = false;
+
+			for (auto& thread : mShardThreads)
+			{
+				if (thread.joinable())
+				{
+					thread.join();
+				}
+			}
+
+			mShardThreads.clear();
+
+			for (const auto& sock : mShardSockets)
+			{
+				ForgetDropCount(sock);
+				closesocket(sock);
+			}
+
+			mShardSockets.clear();
+		}
+
+		void UDP_Client::CloseUnicast()
+		{
+			// Queued datagrams have nowhere left to go, and the event loop must let go of the socket before it closes.
+			{
+				std::lock_guard<std::mutex> lock(mSendQueueLock);
+				if (mSendQueue != nullptr)
+				{
+					mSendQueue->Consume(mSendQueue->Depth());
+					mSendQueueAboveHighWater = false;
+				}
+
+				WatchSendQueue(false);
+			}
+
+			// The receive thread polls its own copy of the sockets, it must let go of them before they close.
+			PauseReceiveThread();
+
+			if (mUring != nullptr && mSocket != INVALID_SOCKET)
+			{
+				mUring->CancelReceive(mSocket);
+			}
+
+			mZeroCopyStates.erase(mSocket);
+			ForgetDropCount(mSocket);
+			closesocket(mSocket);
+			mSocket = INVALID_SOCKET;
+			mPeerPinned = false;
+
+			ResumeReceiveThread();
+		}
+
+		void UDP_Client::CloseBroadcast()
+		{
+			PauseReceiveThread();
+
+			ForgetDropCount(mBroadcastSocket);
+			closesocket(mBroadcastSocket);
+			mBroadcastSocket = INVALID_SOCKET;
+
+			for (const auto& i : mBroadcastListeners)
+			{
+				if (mUring != nullptr)
+				{
+					mUring->CancelReceive(std::get<0>(i));
+				}
+
+				mListenerIndex.erase(std::get<0>(i));
+				ForgetDropCount(std::get<0>(i));
+				closesocket(std::get<0>(i));
+			}
+			
+			mBroadcastListeners.clear();
+
+			ResumeReceiveThread();
+		}
+
+		void UDP_Client::CloseMulticast()
+		{
+			PauseReceiveThread();
+
+			for (const auto& i : mMulticastSockets)
+			{
+				// Shared sockets are closed once below.
+				if (IsSharedMulticastSocket(std::get<0>(i)))
+				{
+					continue;
+				}
+
+				if (mUring != nullptr)
+				{
+					mUring->CancelReceive(std::get<0>(i));
+				}
+
+				mZeroCopyStates.erase(std::get<0>(i));
+				mListenerIndex.erase(std::get<0>(i));
+				ForgetDropCount(std::get<0>(i));
+				closesocket(std::get<0>(i));
+			}
+
+			for (const auto& i : mSharedMulticastSockets)
+			{
+				if (mUring != nullptr)
+				{
+					mUring->CancelReceive(i.sock);
+				}
+
+				mZeroCopyStates.erase(i.sock);
+				mListenerIndex.erase(i.sock);
+				ForgetDropCount(i.sock);
+				closesocket(i.sock);
+			}
+
+			mMulticastSockets.clear();
+			mSharedMulticastSockets.clear();
+			mMulticastGroupIndex.clear();
+
+			ResumeReceiveThread();
+		}
+
+		int8_t UDP_Client::SetTimeToLive(const int8_t ttl)
+		{
+			if (ttl > 0 && ttl < 255)
+			{
+				mTimeToLive = ttl;
+
+				if (mMulticastSockets.size() > 0)
+				{
+					for (const auto& i : mMulticastSockets)
+					{
+						SOCKET sock = std::get<0>(i);
+
+						if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&mTimeToLive, sizeof(mTimeToLive)) == SOCKET_ERROR)
+						{
+							mLastError = UdpClientError::MULTICAST_SET_TTL_FAILED;
+							return -1;
+						}
+					}
+				}
+
+				return 0;
+			}
+
+			return -1;
+		}
+
+		int8_t UDP_Client::SetTimeout(const int32_t timeoutMSecs)
+		{
+			mTimeout.tv_sec = timeoutMSecs / 1000;
+#if WIN32
+			mTimeout.tv_usec = timeoutMSecs * 1000;
+#else
+			mTimeout.tv_usec = static_cast<__suseconds_t>(timeoutMSecs) * 1000;
+#endif
+			return 0;
+		}
+
+		std::string UDP_Client::GetIpOfLastReceive()
+		{
+			return mLastReceiveInfo->ipAddress;
+		}
+
+		int16_t UDP_Client::GetPortOfLastReceive()
+		{
+			return mLastReceiveInfo->port;
+		}
+
+		std::string UDP_Client::GetLastError()
+		{
+			return UdpClientErrorMap[mLastError];
+		}
+	
+		int8_t UDP_Client::ValidateIP(const std::string& ip)
+		{
+			sockaddr_in sa4 = {};
+			sockaddr_in6 sa6 = {};
+
+			// Check if it's a valid IPv4 address
+			if (inet_pton(AF_INET, ip.c_str(), &(sa4.sin_addr)) == 1)
+			{
+				return 1;
+			}
+
+			// Check if it's a valid IPv6 address
+			if (inet_pton(AF_INET6, ip.c_str(), &(sa6.sin6_addr)) == 1)
+			{
+				return 2;
+			}
+
+			return -1;  // Invalid IP address
+		}
+
+		bool UDP_Client::ValidatePort(const int16_t port)
+		{
+			return (port >= 0 && port <= 65535);
+		}
+
+		int32_t UDP_Client::SendTo(const SOCKET sock, const char* buffer, const uint32_t size, const sockaddr_in& destination)
+		{
+			return sendto(sock, buffer, size, 0, (const sockaddr*)&destination, sizeof(destination));
+		}
+
+		int32_t UDP_Client::SendGather(const SOCKET sock, GatherBuffers buffers, const sockaddr* destination, const int32_t length)
+		{
+			// Set the error so no caller mistakes it for a full socket buffer.
+			if (buffers.size() > UDP_MAX_GATHER_BUFFERS)
+			{
+#ifdef WIN32
+				WSASetLastError(WSAEINVAL);
+#else
+				errno = EINVAL;
+#endif
+				return -1;
+			}
+
+#ifdef WIN32
+			WSABUF pieces[UDP_MAX_GATHER_BUFFERS];
+
+			for (size_t i = 0; i < buffers.size(); i++)
+			{
+				pieces[i].buf = const_cast<char*>(buffers[i].data());
+				pieces[i].len = static_cast<ULONG>(buffers[i].size());
+			}
+
+			DWORD numSent = 0;
+			if (WSASendTo(sock, pieces, static_cast<DWORD>(buffers.size()), &numSent, 0, destination, length, nullptr, nullptr) == SOCKET_ERROR)
+			{
+				return -1;
+			}
+
+			return static_cast<int32_t>(numSent);
+#else
+			// The kernel reads each piece straight into the datagram, nothing is joined in user space.
+			iovec pieces[UDP_MAX_GATHER_BUFFERS];
+
+			for (size_t i = 0; i < buffers.size(); i++)
+			{
+				pieces[i].iov_base = const_cast<char*>(buffers[i].data());
+				pieces[i].iov_len = buffers[i].size();
+			}
+
+			msghdr header{};
+			header.msg_name = const_cast<sockaddr*>(destination);
+			header.msg_namelen = destination != nullptr ? static_cast<socklen_t>(length) : 0;
+			header.msg_iov = pieces;
+			header.msg_iovlen = buffers.size();
+
+			return static_cast<int32_t>(sendmsg(sock, &header, 0));
+#endif
+		}
+
+		int32_t UDP_Client::SendOrQueue(GatherBuffers buffers, const sockaddr_in& destination)
+		{
+			size_t size = 0;
+			for (const auto& piece : buffers)
+			{
+				size += piece.size();
+			}
+
+			std::unique_lock<std::mutex> lock(mSendQueueLock);
+
+			// The queue was disabled after the caller looked, send as if it had never been enabled.
+			if (mSendQueue == nullptr)
+			{
+				lock.unlock();
+
+				int32_t numSent = buffers.size() == 1 ? SendTo(mSocket, buffers[0].data(), static_cast<uint32_t>(buffers[0].size()), destination)
+					: SendGather(mSocket, buffers, (const sockaddr*)&destination, sizeof(destination));
+
+				if (numSent == -1)
+				{
+					mLastError = UdpClientError::SEND_FAILED;
+				}
+
+				return numSent;
+			}
+
+			// Datagrams already queued go first so order is kept, a failed one is dropped and reported by GetLastError.
+			if (mSendQueue->ReadableCount() > 0)
+			{
+				DrainSendQueue();
+			}
+
+			if (mSendQueue->ReadableCount() == 0)
+			{
+				int32_t numSent = buffers.size() == 1 ? SendTo(mSocket, buffers[0].data(), static_cast<uint32_t>(buffers[0].size()), destination)
+					: SendGather(mSocket, buffers, (const sockaddr*)&destination, sizeof(destination));
+
+				if (numSent != -1)
+				{
+					return numSent;
+				}
+
+#ifdef WIN32
+				if (WSAGetLastError() != WSAEWOULDBLOCK)
+#else
+				if (errno != EWOULDBLOCK)
+#endif
+				{
+					mLastError = UdpClientError::SEND_FAILED;
+					return -1;
+				}
+			}
+
+			if (mSendQueue->WritableCount() == 0 || size > mSendQueue->WritableSlot(0).capacity)
+			{
+				mLastError = UdpClientError::SEND_QUEUE_FULL;
+				return -1;
+			}
+
+			RingSlot& slot = mSendQueue->WritableSlot(0);
+			slot.size = 0;
+
+			for (const auto& piece : buffers)
+			{
+				memcpy(slot.data + slot.size, piece.data(), piece.size());
+				slot.size += static_cast<uint32_t>(piece.size());
+			}
+
+			slot.source = destination;
+			slot.type = SendType::UNICAST;
+			mSendQueue->Publish(1);
+			WatchSendQueue(true);
+
+			uint32_t depth = 0;
+			bool notify = CheckHighWater(depth);
+			bool above = mSendQueueAboveHighWater;
+			SendQueueCallback callback = notify ? mSendQueueCallback : nullptr;
+			lock.unlock();
+
+			if (callback)
+			{
+				callback(depth, above);
+			}
+
+			return static_cast<int32_t>(size);
+		}
+
+		int32_t UDP_Client::DrainSendQueue()
+		{
+			UdpSendRecord records[UDP_MAX_BATCH_SIZE];
+			int32_t totalSent = 0;
+
+			for (;;)
+			{
+				uint32_t count = std::min(mSendQueue->ReadableCount(), UDP_MAX_BATCH_SIZE);
+
+				if (count == 0)
+				{
+					break;
+				}
+
+				for (uint32_t i = 0; i < count; i++)
+				{
+					const RingSlot& slot = mSendQueue->ReadableSlot(i);
+					records[i] = { slot.data, slot.size, &slot.source, -1 };
+				}
+
+				int32_t errorCode = 0;
+				int32_t numSent = SendBatch(std::span<UdpSendRecord>(records, count), errorCode);
+
+				// The head datagram cannot be sent at all, drop it rather than stall the queue behind it.
+				if (numSent < 0)
+				{
+					mLastError = UdpClientError::SEND_FAILED;
+					mSendQueue->Consume(1);
+					mSendQueueDrops++;
+					WatchSendQueue(mSendQueue->Depth() > 0);
+					return -1;
+				}
+
+				mSendQueue->Consume(static_cast<uint32_t>(numSent));
+				totalSent += numSent;
+
+				// Socket buffer is full again, wait for the next writable wakeup.
+				if (static_cast<uint32_t>(numSent) < count)
+				{
+					break;
+				}
+			}
+
+			WatchSendQueue(mSendQueue->Depth() > 0);
+			return totalSent;
+		}
+
+		int32_t UDP_Client::FlushSendQueue()
+		{
+			std::unique_lock<std::mutex> lock(mSendQueueLock);
+
+			if (mSendQueue == nullptr)
+			{
+				return 0;
+			}
+
+			int32_t numSent = DrainSendQueue();
+
+			uint32_t depth = 0;
+			bool notify = CheckHighWater(depth);
+			bool above = mSendQueueAboveHighWater;
+			SendQueueCallback callback = notify ? mSendQueueCallback : nullptr;
+			lock.unlock();
+
+			if (callback)
+			{
+				callback(depth, above);
+			}
+
+			return numSent;
+		}
+
+		int8_t UDP_Client::HoldSendQueue(std::unique_lock<std::mutex>& lock)
+		{
+			if (!mSendQueueEnabled)
+			{
+				return 0;
+			}
+
+			// A failed head datagram is dropped and counted, the drain carries on from the next one.
+			FlushSendQueue();
+
+			lock = std::unique_lock<std::mutex>(mSendQueueLock);
+
+			if (mSendQueue != nullptr && mSendQueue->Depth() > 0)
+			{
+				lock.unlock();
+				return -1;
+			}
+
+			return 0;
+		}
+
+		void UDP_Client::WatchSendQueue(const bool watch)
+		{
+#if defined __linux__
+			if (watch == mSendQueueWatched || mListenerPoll == INVALID_SOCKET || mSocket == INVALID_SOCKET)
+			{
+				return;
+			}
+
+			epoll_event event{};
+			event.events = EPOLLOUT;
+			event.data.u64 = (UDP_SEND_QUEUE_EVENT << 32) | static_cast<uint32_t>(mSocket);
+
+			// Left unwatched if the loop refuses, PollSendQueue still drains the queue.
+			if (epoll_ctl(mListenerPoll, watch ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, mSocket, &event) != SOCKET_ERROR)
+			{
+				mSendQueueWatched = watch;
+			}
+#endif
+		}
+
+		bool UDP_Client::CheckHighWater(uint32_t& depth)
+		{
+			depth = mSendQueue->Depth();
+
+			// Half the mark on the way down keeps the callback from flapping around it.
+			if (!mSendQueueAboveHighWater && depth >= mSendQueueHighWater)
+			{
+				mSendQueueAboveHighWater = true;
+				return true;
+			}
+
+			if (mSendQueueAboveHighWater && depth <= mSendQueueHighWater / 2)
+			{
+				mSendQueueAboveHighWater = false;
+				return true;
+			}
+
+			return false;
+		}
+
+		int32_t UDP_Client::SendAt(const SOCKET sock, const char* buffer, const uint32_t size, const sockaddr* destination, const int32_t length, const uint64_t departure)
+		{
+#if defined __linux__
+			// Without SO_TXTIME on the socket the kernel refuses the control message.
+			if (!mTransmitTime)
+			{
+				return sendto(sock, buffer, size, 0, destination, length);
+			}
+
+			iovec vector{ const_cast<char*>(buffer), size };
+			char control[CMSG_SPACE(sizeof(departure))] = {};
+
+			msghdr header{};
+			header.msg_name = const_cast<sockaddr*>(destination);
+			header.msg_namelen = length;
+			header.msg_iov = &vector;
+			header.msg_iovlen = 1;
+			header.msg_control = control;
+			header.msg_controllen = sizeof(control);
+
+			cmsghdr* message = CMSG_FIRSTHDR(&header);
+			message->cmsg_level = SOL_SOCKET;
+			message->cmsg_type = SCM_TXTIME;
+			message->cmsg_len = CMSG_LEN(sizeof(departure));
+			memcpy(CMSG_DATA(message), &departure, sizeof(departure));
+
+			return static_cast<int32_t>(sendmsg(sock, &header, 0));
+#else
+			// No departure times, the datagram leaves at once.
+			return sendto(sock, buffer, size, 0, destination, length);
+#endif
+		}
+
+		int32_t UDP_Client::SendZeroCopy(const SOCKET sock, const char* buffer, const uint32_t size, const sockaddr_in& destination, ZeroCopyHandle& handle)
+		{
+#if defined __linux__
+			// Without SO_ZEROCOPY the kernel silently copies and never reports a completion.
+			auto state = mZeroCopyStates.find(sock);
+
+			if (!mZeroCopy || state == mZeroCopyStates.end())
+			{
+				errno = EINVAL;
+				return -1;
+			}
+
+			ssize_t numSent = sendto(sock, buffer, size, MSG_ZEROCOPY, (const sockaddr*)&destination, sizeof(destination));
+
+			if (numSent == -1)
+			{
+				// Out of socket buffer or notification memory, reap completions and try again.
+				if (errno == EWOULDBLOCK || errno == ENOBUFS)
+				{
+					return 0;
+				}
+				return -1;
+			}
+
+			// Each successful send takes the next sequence number of its socket.
+			handle.socket = sock;
+			handle.sequence = state->second.next++;
+
+			return static_cast<int32_t>(numSent);
+#else
+			return -1;
+#endif
+		}
+
+		int8_t UDP_Client::ConfigureZeroCopy(const SOCKET sock, const bool enable)
+		{
+#if defined __linux__
+			int value = enable ? 1 : 0;
+			if (setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &value, sizeof(value)) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+				return -1;
+			}
+
+			// The kernel keeps counting across toggles, so existing tracking is kept.
+			if (enable)
+			{
+				mZeroCopyStates.try_emplace(sock);
+			}
+
+			return 0;
+#else
+			mLastError = UdpClientError::FEATURE_NOT_SUPPORTED;
+			return -1;
+#endif
+		}
+
+		std::vector<UDP_Client::ReceiveSocket> UDP_Client::GetReceiveSockets()
+		{
+			std::vector<ReceiveSocket> sockets;
+
+			if (mSocket != INVALID_SOCKET)
+			{
+				sockets.push_back({ mSocket, SendType::UNICAST });
+			}
+
+			for (const auto& i : mBroadcastListeners)
+			{
+				sockets.push_back({ std::get<0>(i), SendType::BROADCAST });
+			}
+
+			for (const auto& i : mMulticastSockets)
+			{
+				if (!IsSharedMulticastSocket(std::get<0>(i)))
+				{
+					sockets.push_back({ std::get<0>(i), SendType::MULTICAST, std::get<1>(i) });
+				}
+			}
+
+			for (const auto& i : mSharedMulticastSockets)
+			{
+				ReceiveSocket socket{ i.sock, SendType::MULTICAST };
+				socket.group.sin_family = AF_INET;
+				socket.group.sin_port = htons(i.port);
+				socket.shared = true;
+				sockets.push_back(socket);
+			}
+
+			return sockets;
+		}
+
+		void UDP_Client::PauseReceiveThread()
+		{
+			mReceiveThreadRunning = false;
+
+			if (mReceiveThread.joinable())
+			{
+				mReceiveThread.join();
+			}
+		}
+
+		void UDP_Client::ResumeReceiveThread()
+		{
+			if (mReceiveRing == nullptr || mReceiveThread.joinable())
+			{
+				return;
+			}
+
+			std::vector<ReceiveSocket> sockets = GetReceiveSockets();
+
+			if (!sockets.empty())
+			{
+				mReceiveThreadRunning = true;
+				mReceiveThread = std::thread(&UDP_Client::ReceiveThreadLoop, this, std::move(sockets));
+			}
+		}
+
+		void UDP_Client::ReceiveThreadLoop(const std::vector<ReceiveSocket> sockets)
+		{
+#ifdef WIN32
+			std::vector<WSAPOLLFD> pollSet(sockets.size());
+#else
+			std::vector<pollfd> pollSet(sockets.size());
+#endif
+			for (size_t i = 0; i < sockets.size(); i++)
+			{
+				pollSet[i] = {};
+				pollSet[i].fd = sockets[i].sock;
+				pollSet[i].events = POLLIN;
+			}
+
+			while (mReceiveThreadRunning.load(std::memory_order_relaxed))
+			{
+				// Consumer has fallen behind, leave the datagrams queued in the kernel until it catches up.
+				if (mReceiveRing->WritableCount() == 0)
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+					continue;
+				}
+
+				// Wake up regularly to notice a stop request.
+#ifdef WIN32
+				int readyCount = WSAPoll(pollSet.data(), static_cast<ULONG>(pollSet.size()), 100);
+#else
+				int readyCount = poll(pollSet.data(), pollSet.size(), 100);
+#endif
+
+				if (readyCount <= 0)
+				{
+					continue;
+				}
+
+				for (size_t i = 0; i < pollSet.size(); i++)
+				{
+					if ((pollSet[i].revents & POLLIN) != 0)
+					{
+						ReceiveIntoRing(sockets[i]);
+					}
+				}
+			}
+		}
+
+		uint32_t UDP_Client::ReceiveIntoRing(const ReceiveSocket& socket)
+		{
+			const SOCKET sock = socket.sock;
+			const SendType type = socket.type;
+
+			uint32_t count = std::min(mReceiveRing->WritableCount(), UDP_MAX_BATCH_SIZE);
+
+			if (count == 0)
+			{
+				return 0;
+			}
+
+#if defined __linux__
+			mmsghdr messages[UDP_MAX_BATCH_SIZE];
+			iovec	vectors[UDP_MAX_BATCH_SIZE];
+			char	controls[UDP_MAX_BATCH_SIZE][CMSG_SPACE(sizeof(in_pktinfo)) + UDP_RECEIVE_CONTROL_SIZE];
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				RingSlot& slot = mReceiveRing->WritableSlot(i);
+
+				vectors[i].iov_base = slot.data;
+				vectors[i].iov_len = slot.capacity;
+
+				messages[i] = {};
+				messages[i].msg_hdr.msg_name = &slot.source;
+				messages[i].msg_hdr.msg_namelen = sizeof(slot.source);
+				messages[i].msg_hdr.msg_iov = &vectors[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+
+				if (mReceiveTimestamps || mDropAccounting || socket.shared)
+				{
+					messages[i].msg_hdr.msg_control = controls[i];
+					messages[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+				}
+			}
+
+			int numReceived = recvmmsg(sock, messages, count, MSG_DONTWAIT, nullptr);
+
+			if (numReceived <= 0)
+			{
+				return 0;
+			}
+
+			for (int i = 0; i < numReceived; i++)
+			{
+				RingSlot& slot = mReceiveRing->WritableSlot(i);
+				slot.size = messages[i].msg_len;
+				slot.socket = sock;
+				slot.type = type;
+				slot.group = socket.group;
+				slot.truncated = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+				slot.timestamp = 0;
+
+				uint64_t hardwareTimestamp = 0;
+				uint32_t drops = 0;
+				for (cmsghdr* message = CMSG_FIRSTHDR(&messages[i].msg_hdr); message != nullptr; message = CMSG_NXTHDR(&messages[i].msg_hdr, message))
+				{
+					// A shared socket names each datagram's group by its destination address.
+					if (message->cmsg_level == IPPROTO_IP && message->cmsg_type == IP_PKTINFO)
+					{
+						in_pktinfo info{};
+						memcpy(&info, CMSG_DATA(message), sizeof(info));
+						slot.group.sin_addr = info.ipi_addr;
+					}
+					else if (!ReadDropCount(message, sock, drops))
+					{
+						ReadTimestamp(message, slot.timestamp, hardwareTimestamp);
+					}
+				}
+			}
+#else
+			int numReceived = 0;
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				RingSlot& slot = mReceiveRing->WritableSlot(i);
+				int addressLength = sizeof(slot.source);
+				int32_t sizeRead = recvfrom(sock, slot.data, slot.capacity, 0, (sockaddr*)&slot.source, &addressLength);
+
+				if (sizeRead == -1)
+				{
+					if (WSAGetLastError() != WSAEMSGSIZE)
+					{
+						break;
+					}
+
+					sizeRead = slot.capacity;
+					slot.truncated = true;
+				}
+				else
+				{
+					slot.truncated = false;
+				}
+
+				slot.size = sizeRead;
+				slot.socket = sock;
+				slot.type = type;
+				slot.group = socket.group;
+				numReceived++;
+
+				// Listener sockets block, only the first read is known to have data.
+				if (type != SendType::UNICAST)
+				{
+					break;
+				}
+			}
+#endif
+
+			mReceiveRing->Publish(static_cast<uint32_t>(numReceived));
+			return static_cast<uint32_t>(numReceived);
+		}
+
+		void UDP_Client::ShardThreadLoop(const uint32_t shard, const int32_t cpu, const uint32_t slotSize)
+		{
+#if defined __linux__
+			if (cpu >= 0)
+			{
+				cpu_set_t cpuSet;
+				CPU_ZERO(&cpuSet);
+				CPU_SET(cpu % CPU_SETSIZE, &cpuSet);
+				pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+			}
+
+			SOCKET sock = mShardSockets[shard];
+
+			// Each worker owns its receive slots, nothing is shared between shards.
+			std::vector<char> storage(static_cast<size_t>(UDP_MAX_BATCH_SIZE) * slotSize);
+			UdpReceiveSlot slots[UDP_MAX_BATCH_SIZE];
+			mmsghdr messages[UDP_MAX_BATCH_SIZE];
+			iovec	vectors[UDP_MAX_BATCH_SIZE];
+			char	controls[UDP_MAX_BATCH_SIZE][UDP_RECEIVE_CONTROL_SIZE];
+
+			for (uint32_t i = 0; i < UDP_MAX_BATCH_SIZE; i++)
+			{
+				slots[i].buffer = &storage[static_cast<size_t>(i) * slotSize];
+				slots[i].maxSize = slotSize;
+			}
+
+			pollfd pollSet{ sock, POLLIN, 0 };
+
+			while (mShardsRunning.load(std::memory_order_relaxed))
+			{
+				// Wake up regularly to notice a stop request.
+				if (poll(&pollSet, 1, 100) <= 0)
+				{
+					continue;
+				}
+
+				for (uint32_t i = 0; i < UDP_MAX_BATCH_SIZE; i++)
+				{
+					vectors[i].iov_base = slots[i].buffer;
+					vectors[i].iov_len = slots[i].maxSize;
+
+					messages[i] = {};
+					messages[i].msg_hdr.msg_name = &slots[i].source;
+					messages[i].msg_hdr.msg_namelen = sizeof(slots[i].source);
+					messages[i].msg_hdr.msg_iov = &vectors[i];
+					messages[i].msg_hdr.msg_iovlen = 1;
+
+					if (mReceiveTimestamps || mDropAccounting)
+					{
+						messages[i].msg_hdr.msg_control = controls[i];
+						messages[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+					}
+				}
+
+				int numReceived = recvmmsg(sock, messages, UDP_MAX_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+
+				for (int i = 0; i < numReceived; i++)
+				{
+					slots[i].length = messages[i].msg_len;
+					slots[i].truncated = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+					slots[i].drops = 0;
+					slots[i].timestamp = 0;
+					slots[i].hardwareTimestamp = 0;
+
+					for (cmsghdr* message = CMSG_FIRSTHDR(&messages[i].msg_hdr); message != nullptr; message = CMSG_NXTHDR(&messages[i].msg_hdr, message))
+					{
+						if (!ReadDropCount(message, sock, slots[i].drops))
+						{
+							ReadTimestamp(message, slots[i].timestamp, slots[i].hardwareTimestamp);
+						}
+					}
+
+					mShardCallback(shard, slots[i]);
+				}
+			}
+#endif
+		}
+
+		int8_t UDP_Client::OpenListenerPoll()
+		{
+#if defined __linux__
+			if (mListenerPoll == INVALID_SOCKET)
+			{
+				mListenerPoll = epoll_create1(EPOLL_CLOEXEC);
+
+				if (mListenerPoll == INVALID_SOCKET)
+				{
+					mLastError = UdpClientError::EVENT_LOOP_FAILED;
+					return -1;
+				}
+			}
+#endif
+			return 0;
+		}
+
+		int8_t UDP_Client::RegisterListener(const SOCKET sock, const SendType type, const size_t index)
+		{
+#if defined __linux__
+			if (OpenListenerPoll() < 0)
+			{
+				return -1;
+			}
+
+			// The socket names the listener, an index would point elsewhere once a callback changes the lists.
+			epoll_event event{};
+			event.events = EPOLLIN;
+			event.data.u64 = (static_cast<uint64_t>(type) << 32) | static_cast<uint32_t>(sock);
+
+			if (epoll_ctl(mListenerPoll, EPOLL_CTL_ADD, sock, &event) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::EVENT_LOOP_FAILED;
+				return -1;
+			}
+
+			mListenerIndex[sock] = index;
+#endif
+			return 0;
+		}
+
+		int32_t UDP_Client::DispatchListener(const SendType type, const size_t index)
+		{
+			if (type == SendType::MULTICAST && (index & UDP_SHARED_LISTENER) != 0)
+			{
+				return DispatchSharedMulticast(index & ~UDP_SHARED_LISTENER);
+			}
+
+			const auto& listeners = (type == SendType::BROADCAST) ? mBroadcastListeners : mMulticastSockets;
+			const ListenerCallback& callback = (type == SendType::BROADCAST) ? mBroadcastCallback : mMulticastCallback;
+
+			if (index >= listeners.size())
+			{
+				return 0;
+			}
+
+			if (mListenerBuffer.size() < UDP_MAX_DATAGRAM_SIZE)
+			{
+				mListenerBuffer.resize(UDP_MAX_DATAGRAM_SIZE);
+			}
+
+			// Copied, a callback adding a listener may move the list.
+			SOCKET sock = std::get<0>(listeners[index]);
+			sockaddr_in listener = std::get<1>(listeners[index]);
+
+			ListenerDatagram datagram{};
+			datagram.type = type;
+			datagram.listener = &listener;
+			datagram.data = mListenerBuffer.data();
+
+			// Drain up to a batch per wakeup so one busy listener cannot starve the others.
+			int32_t dispatched = 0;
+			while (dispatched < static_cast<int32_t>(UDP_MAX_BATCH_SIZE))
+			{
+#if defined WIN32
+				int recvFromSize = sizeof(datagram.sender);
+				int32_t receivedBytes = recvfrom(sock, mListenerBuffer.data(), (int)mListenerBuffer.size(), 0, reinterpret_cast<sockaddr*>(&datagram.sender), &recvFromSize);
+#else
+				iovec vector{ mListenerBuffer.data(), mListenerBuffer.size() };
+				char control[UDP_RECEIVE_CONTROL_SIZE];
+
+				msghdr header{};
+				header.msg_name = &datagram.sender;
+				header.msg_namelen = sizeof(datagram.sender);
+				header.msg_iov = &vector;
+				header.msg_iovlen = 1;
+
+				if (mReceiveTimestamps || mDropAccounting)
+				{
+					header.msg_control = control;
+					header.msg_controllen = sizeof(control);
+				}
+
+				int32_t receivedBytes = static_cast<int32_t>(recvmsg(sock, &header, MSG_DONTWAIT));
+#endif
+
+				if (receivedBytes == SOCKET_ERROR)
+				{
+#ifdef WIN32
+					int errorCode = WSAGetLastError();
+					if (errorCode != WSAEWOULDBLOCK)
+#else
+					if (errno != EWOULDBLOCK)
+#endif
 					{
-						continue;
+						mLastError = (type == SendType::BROADCAST) ? UdpClientError::RECEIVE_BROADCAST_FAILED : UdpClientError::READ_FAILED;
+						return -1;
 					}
+					break;
+				}
 
-					if (sock != INVALID_SOCKET)
+				datagram.size = receivedBytes;
+				datagram.timestamp = 0;
+
+#if defined __linux__
+				uint64_t hardwareTimestamp = 0;
+				uint32_t drops = 0;
+				for (cmsghdr* message = CMSG_FIRSTHDR(&header); message != nullptr; message = CMSG_NXTHDR(&header, message))
+				{
+					if (!ReadDropCount(message, sock, drops))
 					{
-						// Verify incoming data is available.
-						fd_set readSet{};
-						FD_ZERO(&readSet);
-						FD_SET(sock, &readSet);
-						sockaddr_in recvFrom{};
-						int recvFromSize = sizeof(recvFrom);
+						ReadTimestamp(message, datagram.timestamp, hardwareTimestamp);
+					}
+				}
+#endif
 
-						int selectResult = select((int)sock + 1, &readSet, nullptr, nullptr, &mTimeout);
+				if (callback)
+				{
+					callback(datagram);
+				}
 
-						// Catch error
-						if (selectResult == SOCKET_ERROR)
-						{
-							mLastError = UdpClientError::SELECT_READ_ERROR;
-							return 1;
-						}
+				dispatched++;
 
-						// If data is available on this socket, attempt to read it 
-						if (selectResult > 0)
-						{
-#if defined WIN32
-							int32_t receivedBytes = recvfrom(sock, (char*)buffer, maxSize - 1, 0, reinterpret_cast<sockaddr*>(&recvFrom), &recvFromSize);
+				// The callback closed the listener, its socket is gone or belongs to another.
+				if (index >= listeners.size() || std::get<0>(listeners[index]) != sock)
+				{
+					break;
+				}
+
+#ifdef WIN32
+				// Only one datagram is known to be waiting on a blocking listener.
+				break;
+#endif
+			}
+
+			return dispatched;
+		}
+
+		int32_t UDP_Client::DispatchSharedMulticast(const size_t shared)
+		{
+			if (mListenerBuffer.size() < UDP_MAX_DATAGRAM_SIZE)
+			{
+				mListenerBuffer.resize(UDP_MAX_DATAGRAM_SIZE);
+			}
+
+			ListenerDatagram datagram{};
+			datagram.type = SendType::MULTICAST;
+			datagram.data = mListenerBuffer.data();
+
+			// Drain up to a batch per wakeup, same as the single group listeners.
+			int32_t dispatched = 0;
+			for (uint32_t reads = 0; reads < UDP_MAX_BATCH_SIZE; reads++)
+			{
+				size_t group = mMulticastSockets.size();
+				int32_t receivedBytes = ReceiveShared(shared, mListenerBuffer.data(), static_cast<uint32_t>(mListenerBuffer.size()), datagram.sender, group, datagram.timestamp);
+
+				if (receivedBytes < 0)
+				{
+					return -1;
+				}
+
+				if (receivedBytes == 0)
+				{
+					break;
+				}
+
+				// Sent to a group we have not joined, nothing to hand it to.
+				if (group >= mMulticastSockets.size())
+				{
+					continue;
+				}
+
+				sockaddr_in listener = std::get<1>(mMulticastSockets[group]);
+				datagram.listener = &listener;
+				datagram.size = receivedBytes;
+
+				if (mMulticastCallback)
+				{
+					mMulticastCallback(datagram);
+				}
+
+				dispatched++;
+
+				if (shared >= mSharedMulticastSockets.size())
+				{
+					break;
+				}
+			}
+
+			return dispatched;
+		}
+
+		int32_t UDP_Client::ReceiveShared(const size_t shared, void* buffer, const uint32_t maxSize, sockaddr_in& sender, size_t& group, uint64_t& timestamp)
+		{
+#if defined __linux__
+			const SharedMulticastSocket& entry = mSharedMulticastSockets[shared];
+
+			iovec vector{ buffer, maxSize };
+			char control[CMSG_SPACE(sizeof(in_pktinfo)) + UDP_RECEIVE_CONTROL_SIZE] = {};
+			timestamp = 0;
+
+			msghdr header{};
+			header.msg_name = &sender;
+			header.msg_namelen = sizeof(sender);
+			header.msg_iov = &vector;
+			header.msg_iovlen = 1;
+			header.msg_control = control;
+			header.msg_controllen = sizeof(control);
+
+			ssize_t receivedBytes = recvmsg(entry.sock, &header, MSG_DONTWAIT);
+
+			if (receivedBytes == -1)
+			{
+				if (errno == EWOULDBLOCK)
+				{
+					return 0;
+				}
+
+				mLastError = UdpClientError::READ_FAILED;
+				return -1;
+			}
+
+			// The destination address names the group, one lookup whatever the number of groups.
+			for (cmsghdr* message = CMSG_FIRSTHDR(&header); message != nullptr; message = CMSG_NXTHDR(&header, message))
+			{
+				if (message->cmsg_level == IPPROTO_IP && message->cmsg_type == IP_PKTINFO)
+				{
+					in_pktinfo info{};
+					memcpy(&info, CMSG_DATA(message), sizeof(info));
+
+					size_t found = LookupMulticastGroup(info.ipi_addr, htons(entry.port));
+					if (found < mMulticastSockets.size())
+					{
+						group = found;
+					}
+				}
+				else
+				{
+					uint64_t hardwareTimestamp = 0;
+					uint32_t drops = 0;
+
+					if (!ReadDropCount(message, entry.sock, drops))
+					{
+						ReadTimestamp(message, timestamp, hardwareTimestamp);
+					}
+				}
+			}
+
+			return static_cast<int32_t>(receivedBytes);
 #else
-							int32_t receivedBytes = recvfrom(mSocket, buffer, static_cast<size_t>(maxSize) - 1, 0, (sockaddr*)&recvFrom, reinterpret_cast<socklen_t*>(&recvFromSize));
+			// Shared sockets are only opened on linux.
+			timestamp = 0;
+			return 0;
 #endif
+		}
 
-							if (receivedBytes == SOCKET_ERROR)
-							{
+		SOCKET UDP_Client::OpenMulticastSocket(const int16_t port, const bool shared)
+		{
+			// Create a UDP socket
+			SOCKET sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+			if (sock == INVALID_SOCKET)
+			{
+				mLastError = UdpClientError::BAD_MULTICAST_ADDRESS;
+				return INVALID_SOCKET;
+			}
+
+			// Enable SO_REUSEADDR to allow multiple sockets to bind to the same address
+			int reuseAddr = 1;
+			if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuseAddr, sizeof(reuseAddr)) == SOCKET_ERROR)
+			{
+				closesocket(sock);
+				mLastError = UdpClientError::ENABLE_REUSEADDR_FAILED;
+				return INVALID_SOCKET;
+			}
+
+			// Bind the socket to a local IP address
+			sockaddr_in localAddr{};
+			localAddr.sin_family = AF_INET;
+			localAddr.sin_port = htons(port);
+			localAddr.sin_addr.s_addr = INADDR_ANY;
+
+			if (ApplySocketOptions(sock, SendType::MULTICAST) < 0)
+			{
+				closesocket(sock);
+				return INVALID_SOCKET;
+			}
+
+			// Bind the socket to the multicast address
+			if (bind(sock, (sockaddr*)&localAddr, sizeof(localAddr)) < 0)
+			{
+				closesocket(sock);
+				mLastError = UdpClientError::MULTICAST_BIND_FAILED;
+				return INVALID_SOCKET;
+			}
+
+			// Set the TTL (time to live) for any outpoing multicast packets to 5 hops
+			if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&mTimeToLive, sizeof(mTimeToLive)) == SOCKET_ERROR)
+			{
+				closesocket(sock);
+				mLastError = UdpClientError::MULTICAST_SET_TTL_FAILED;
+				return INVALID_SOCKET;
+			}
+
+			// Set the outgoing interface for multicast packets
+			in_addr interfaceAddr {};
+			interfaceAddr.s_addr = INADDR_ANY;
+			if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, (char*)&interfaceAddr, sizeof(interfaceAddr)) < 0) 
+			{
+				closesocket(sock);
+				mLastError = UdpClientError::MULTICAST_INTERFACE_ERROR;
+				return INVALID_SOCKET;
+			}
+
+#if defined __linux__
+			// A shared socket needs each datagram's group, and only the groups it joined itself.
+			if (shared)
+			{
+				int enablePacketInfo = 1;
+				int multicastAll = 0;
+
+				if (setsockopt(sock, IPPROTO_IP, IP_PKTINFO, &enablePacketInfo, sizeof(enablePacketInfo)) == SOCKET_ERROR ||
+					setsockopt(sock, IPPROTO_IP, IP_MULTICAST_ALL, &multicastAll, sizeof(multicastAll)) == SOCKET_ERROR)
+				{
+					closesocket(sock);
+					mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+					return INVALID_SOCKET;
+				}
+			}
+#endif
+
+			// Set the socket to non-blocking mode
 #ifdef WIN32
-								int errorCode = WSAGetLastError();
-								if (errorCode != WSAEWOULDBLOCK)
-								{
-									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
-									return -1;
-								}
+			u_long mode = 1;
+			if (ioctlsocket(sock, FIONBIO, &mode) != 0) 
+			{
+				closesocket(sock);
+				return INVALID_SOCKET;
+			}
 #else
-								if (errno != EWOULDBLOCK)
-								{
-									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
-									return -1;
-								}
+			int flags = fcntl(sock, F_GETFL, 0);
+			if (flags == -1)
+			{
+				closesocket(sock);
+				mLastError = UdpClientError::FAILED_TO_GET_SOCKET_FLAGS;
+				return INVALID_SOCKET;
+			}
+
+			if (fcntl(sock, F_SETFL, flags | O_NONBLOCK) == -1)
+			{
+				closesocket(sock);
+				mLastError = UdpClientError::FAILED_TO_SET_NONBLOCK;
+				return INVALID_SOCKET;
+			}
 #endif
-								return 0;
-							}
 
-							mLastRecvBroadcastPort = ntohs(addr.sin_port);
-							return receivedBytes;
-						}
+			return sock;
+		}
+
+		int8_t UDP_Client::ApplySocketOptions(const SOCKET sock, const SendType type)
+		{
+			if (ApplyFilter(sock, type) < 0 || ApplyBufferSizes(sock, type) < 0)
+			{
+				return -1;
+			}
+
+			if (type == SendType::UNICAST && mBusyPollBudget > 0)
+			{
+				ConfigureBusyPoll(sock);
+			}
+
+			if (mReceiveTimestamps && ApplyTimestamps(sock) < 0)
+			{
+				return -1;
+			}
+
+			if (mTransmitTime && type != SendType::BROADCAST && ApplyTransmitTime(sock) < 0)
+			{
+				return -1;
+			}
+
+#if defined __linux__
+			int enable = 1;
+			if (mDropAccounting && setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+				return -1;
+			}
+#endif
+			return 0;
+		}
+
+		int8_t UDP_Client::ApplyTimestamps(const SOCKET sock)
+		{
+#if defined __linux__
+			int software = mReceiveTimestamps && !mHardwareTimestamps ? 1 : 0;
+			int stamping = 0;
+
+			// Hardware stamping reports the software stamp too, so only one of the two options is ever on.
+			if (mHardwareTimestamps)
+			{
+				stamping = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
 
-						// If here, selectResult == 0, so we check next socket. 
-					}
+				if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPING, &stamping, sizeof(stamping)) == SOCKET_ERROR)
+				{
+					software = 1;
 				}
+			}
+			else
+			{
+				setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPING, &stamping, sizeof(stamping));
+			}
 
-				// If here, for loop completed, and all have no data. 
-				return 0;
+			if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &software, sizeof(software)) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+				return -1;
 			}
-			return -1;
+#endif
+			return 0;
 		}
 
-		int8_t UDP_Client::ReceiveMulticast(void* buffer, const uint32_t maxSize, std::string& multicastGroup)
+		int8_t UDP_Client::ApplyTransmitTime(const SOCKET sock)
 		{
-			if (mMulticastSockets.size() > 0)
+#if defined __linux__
+			// The kernel cannot turn SO_TXTIME back off, disabling only stops SendAt attaching departure times.
+			if (!mTransmitTime)
 			{
-				for (const auto& i : mMulticastSockets)
-				{
-					// Grab the socket and addr info from the vector for use.
-					SOCKET sock = std::get<0>(i);
-					sockaddr_in addr = std::get<1>(i);
+				return 0;
+			}
 
-					if (sock != INVALID_SOCKET)
-					{
-						// Verify incoming data is available.
-						fd_set readSet{};
-						FD_ZERO(&readSet);
-						FD_SET(sock, &readSet);
-						sockaddr_in recvFrom{};
-						int recvFromSize = sizeof(recvFrom);
+			// CLOCK_MONOTONIC is the clock fq expects and the one behind std::chrono::steady_clock.
+			sock_txtime config{};
+			config.clockid = CLOCK_MONOTONIC;
+			config.flags = 0;
 
-						int selectResult = select(0, &readSet, nullptr, nullptr, &mTimeout);
+			if (setsockopt(sock, SOL_SOCKET, SO_TXTIME, &config, sizeof(config)) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+				return -1;
+			}
+#endif
+			return 0;
+		}
 
-						// Catch error
-						if (selectResult == SOCKET_ERROR)
-						{
-							mLastError = UdpClientError::SELECT_READ_ERROR;
-							return 1;
-						}
+		void UDP_Client::ForgetDropCount(const SOCKET sock)
+		{
+			std::lock_guard<std::mutex> lock(mDropLock);
+			mSocketDrops.erase(sock);
+		}
 
-						// If data is available on this socket, attempt to read it 
-						if (selectResult > 0)
-						{
-#if defined WIN32
-							int32_t receivedBytes = recvfrom(sock, (char*)buffer, maxSize - 1, 0, reinterpret_cast<sockaddr*>(&recvFrom), &recvFromSize);
-#else
-							int32_t receivedBytes = recvfrom(mSocket, buffer, static_cast<size_t>(maxSize) - 1, 0, (sockaddr*)&recvFrom, reinterpret_cast<socklen_t*>(&recvFromSize));
-#endif
+#if defined __linux__
+		bool UDP_Client::ReadDropCount(const cmsghdr* message, const SOCKET sock, uint32_t& drops)
+		{
+			if (message->cmsg_level != SOL_SOCKET || message->cmsg_type != SO_RXQ_OVFL)
+			{
+				return false;
+			}
 
-							if (receivedBytes == SOCKET_ERROR)
-							{
-#ifdef WIN32
-								int errorCode = WSAGetLastError();
-								if (errorCode != WSAEWOULDBLOCK)
-								{
-									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
-									return -1;
-								}
-#else
-								if (errno != EWOULDBLOCK)
-								{
-									mLastError = UdpClientError::RECEIVE_BROADCAST_FAILED;
-									return -1;
-								}
-#endif
-								return 0;
-							}
+			memcpy(&drops, CMSG_DATA(message), sizeof(drops));
 
-							char address[INET_ADDRSTRLEN];
-							if (inet_ntop(AF_INET, &(addr.sin_addr), address, INET_ADDRSTRLEN) != NULL)
-							{
-								multicastGroup = address;
-							}
+			std::lock_guard<std::mutex> lock(mDropLock);
+			mSocketDrops[sock] = drops;
+			return true;
+		}
 
-							return receivedBytes;
-						}
+		bool UDP_Client::ReadTimestamp(const cmsghdr* message, uint64_t& timestamp, uint64_t& hardwareTimestamp)
+		{
+			if (message->cmsg_level != SOL_SOCKET)
+			{
+				return false;
+			}
 
-						// If here, selectResult == 0, so we check next socket. 
-					}
-				}
+			if (message->cmsg_type == SCM_TIMESTAMPNS)
+			{
+				timespec stamp{};
+				memcpy(&stamp, CMSG_DATA(message), sizeof(stamp));
+				timestamp = static_cast<uint64_t>(stamp.tv_sec) * 1000000000 + static_cast<uint64_t>(stamp.tv_nsec);
+			}
+			else if (message->cmsg_type == SCM_TIMESTAMPING)
+			{
+				// Software stamp first, the raw NIC stamp last, the middle one is deprecated.
+				scm_timestamping stamps{};
+				memcpy(&stamps, CMSG_DATA(message), sizeof(stamps));
+				timestamp = static_cast<uint64_t>(stamps.ts[0].tv_sec) * 1000000000 + static_cast<uint64_t>(stamps.ts[0].tv_nsec);
+				hardwareTimestamp = static_cast<uint64_t>(stamps.ts[2].tv_sec) * 1000000000 + static_cast<uint64_t>(stamps.ts[2].tv_nsec);
+			}
+			else
+			{
+				return false;
+			}
 
-				// If here, for loop completed, and all have no data. 
-				return 0;
+			// The kernel stamps with the realtime clock, the delay is how long the datagram sat in the socket.
+			timespec now{};
+			clock_gettime(CLOCK_REALTIME, &now);
+			uint64_t received = static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+
+			if (timestamp != 0 && received >= timestamp)
+			{
+				std::lock_guard<std::mutex> lock(mQueueDelayLock);
+				mQueueDelay.Record(received - timestamp);
 			}
-			return -1;
+
+			return true;
 		}
+#endif
 
-		void UDP_Client::CloseUnicast()
+		void UDP_Client::ConfigureBusyPoll(const SOCKET sock)
 		{
-			closesocket(mSocket);
-			mSocket = INVALID_SOCKET;
+#if defined __linux__
+			// Best effort, past net.core.busy_read the kernel wants CAP_NET_ADMIN and the user space spin still works without it.
+			int budget = static_cast<int>(mBusyPollBudget);
+			int prefer = mBusyPollBudget > 0 ? 1 : 0;
+
+			setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &budget, sizeof(budget));
+			setsockopt(sock, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+#endif
 		}
 
-		void UDP_Client::CloseBroadcast()
+		int8_t UDP_Client::ApplyBufferSizes(const SOCKET sock, const SendType type)
 		{
-			closesocket(mBroadcastSocket);
-			mBroadcastSocket = INVALID_SOCKET;
+			const SocketBufferSizes& sizes = mBufferSizes[static_cast<size_t>(type)];
 
-			for (const auto& i : mBroadcastListeners)
+			if (sizes.receive > 0)
 			{
-				closesocket(std::get<0>(i));
+				bool applied = false;
+#if defined __linux__
+				// Only privileged processes may go past net.core.rmem_max, everyone else falls back below.
+				applied = setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &sizes.receive, sizeof(sizes.receive)) != SOCKET_ERROR;
+#endif
+				if (!applied && setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&sizes.receive, sizeof(sizes.receive)) == SOCKET_ERROR)
+				{
+					mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+					return -1;
+				}
 			}
-			
-			mBroadcastListeners.clear();
+
+			if (sizes.send > 0)
+			{
+				bool applied = false;
+#if defined __linux__
+				applied = setsockopt(sock, SOL_SOCKET, SO_SNDBUFFORCE, &sizes.send, sizeof(sizes.send)) != SOCKET_ERROR;
+#endif
+				if (!applied && setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (const char*)&sizes.send, sizeof(sizes.send)) == SOCKET_ERROR)
+				{
+					mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+					return -1;
+				}
+			}
+
+			return 0;
 		}
 
-		void UDP_Client::CloseMulticast()
+		int8_t UDP_Client::ApplyFilter(const SOCKET sock, const SendType type)
 		{
-			for (const auto& i : mMulticastSockets)
+#if defined __linux__
+			std::vector<SocketFilterInstruction>& program = mFilters[static_cast<size_t>(type)];
+
+			if (program.empty())
 			{
-				closesocket(std::get<0>(i));
+				return 0;
 			}
 
-			mMulticastSockets.clear();
+			static_assert(sizeof(SocketFilterInstruction) == sizeof(sock_filter), "filter instructions must match sock_filter");
+			sock_fprog filter{ static_cast<unsigned short>(program.size()), reinterpret_cast<sock_filter*>(program.data()) };
+
+			if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) == SOCKET_ERROR)
+			{
+				mLastError = UdpClientError::SOCKET_OPTION_FAILED;
+				return -1;
+			}
+#endif
+			return 0;
 		}
 
-		int8_t UDP_Client::SetTimeToLive(const int8_t ttl)
+		std::vector<SOCKET> UDP_Client::GetSockets(const SendType type)
 		{
-			if (ttl > 0 && ttl < 255)
+			std::vector<SOCKET> sockets;
+
+			if (type == SendType::UNICAST)
 			{
-				mTimeToLive = ttl;
+				if (mSocket != INVALID_SOCKET)
+				{
+					sockets.push_back(mSocket);
+				}
 
-				if (mMulticastSockets.size() > 0)
+				sockets.insert(sockets.end(), mShardSockets.begin(), mShardSockets.end());
+			}
+			else if (type == SendType::BROADCAST)
+			{
+				if (mBroadcastSocket != INVALID_SOCKET)
 				{
-					for (const auto& i : mMulticastSockets)
-					{
-						SOCKET sock = std::get<0>(i);
+					sockets.push_back(mBroadcastSocket);
+				}
 
-						if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&mTimeToLive, sizeof(mTimeToLive)) == SOCKET_ERROR)
-						{
-							mLastError = UdpClientError::MULTICAST_SET_TTL_FAILED;
-							return -1;
-						}
+				for (const auto& i : mBroadcastListeners)
+				{
+					sockets.push_back(std::get<0>(i));
+				}
+			}
+			else
+			{
+				for (const auto& i : mMulticastSockets)
+				{
+					if (!IsSharedMulticastSocket(std::get<0>(i)))
+					{
+						sockets.push_back(std::get<0>(i));
 					}
 				}
 
-				return 0;
+				for (const auto& i : mSharedMulticastSockets)
+				{
+					sockets.push_back(i.sock);
+				}
 			}
 
-			return -1;
+			return sockets;
 		}
 
-		int8_t UDP_Client::SetTimeout(const int32_t timeoutMSecs)
+		int8_t UDP_Client::JoinMulticastGroup(const SOCKET sock, const in_addr group, const std::vector<in_addr>& sources)
 		{
-			mTimeout.tv_sec = timeoutMSecs / 1000;
-#if WIN32
-			mTimeout.tv_usec = timeoutMSecs * 1000;
+			if (sources.empty())
+			{
+				ip_mreq multicastRequest{};
+				multicastRequest.imr_multiaddr = group;
+				multicastRequest.imr_interface.s_addr = INADDR_ANY;
+
+				return setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&multicastRequest, sizeof(multicastRequest)) == SOCKET_ERROR ? -1 : 0;
+			}
+
+			// Each source extends the kernel's include filter, traffic from anyone else never reaches the socket.
+			for (size_t i = 0; i < sources.size(); i++)
+			{
+				ip_mreq_source sourceRequest{};
+				sourceRequest.imr_multiaddr = group;
+				sourceRequest.imr_sourceaddr = sources[i];
+				sourceRequest.imr_interface.s_addr = INADDR_ANY;
+
+				if (setsockopt(sock, IPPROTO_IP, IP_ADD_SOURCE_MEMBERSHIP, (const char*)&sourceRequest, sizeof(sourceRequest)) == SOCKET_ERROR)
+				{
+					// Dropping the group drops the sources already added with it, keep the join's error for the caller.
+					if (i > 0)
+					{
+#ifdef WIN32
+						int errorCode = WSAGetLastError();
 #else
-			mTimeout.tv_usec = static_cast<__suseconds_t>(timeoutMSecs) * 1000;
+						int errorCode = errno;
+#endif
+						ip_mreq multicastRequest{};
+						multicastRequest.imr_multiaddr = group;
+						multicastRequest.imr_interface.s_addr = INADDR_ANY;
+						setsockopt(sock, IPPROTO_IP, IP_DROP_MEMBERSHIP, (const char*)&multicastRequest, sizeof(multicastRequest));
+#ifdef WIN32
+						WSASetLastError(errorCode);
+#else
+						errno = errorCode;
 #endif
+					}
+
+					return -1;
+				}
+			}
+
 			return 0;
 		}
 
-		std::string UDP_Client::GetIpOfLastReceive()
+		int32_t UDP_Client::AcquireSharedMulticastSocket(const int16_t port)
 		{
-			return mLastReceiveInfo->ipAddress;
-		}
+			for (size_t i = 0; i < mSharedMulticastSockets.size(); i++)
+			{
+				if (mSharedMulticastSockets[i].port == port && mSharedMulticastSockets[i].groups < UDP_MAX_GROUPS_PER_SOCKET)
+				{
+					return static_cast<int32_t>(i);
+				}
+			}
 
-		int16_t UDP_Client::GetPortOfLastReceive()
-		{
-			return mLastReceiveInfo->port;
-		}
+			SOCKET sock = OpenMulticastSocket(port, true);
 
-		std::string UDP_Client::GetLastError()
-		{
-			return UdpClientErrorMap[mLastError];
-		}
-	
-		int8_t UDP_Client::ValidateIP(const std::string& ip)
-		{
-			sockaddr_in sa4 = {};
-			sockaddr_in6 sa6 = {};
+			if (sock == INVALID_SOCKET)
+			{
+				return -1;
+			}
 
-			// Check if it's a valid IPv4 address
-			if (inet_pton(AF_INET, ip.c_str(), &(sa4.sin_addr)) == 1)
+			if (mZeroCopy && ConfigureZeroCopy(sock, true) < 0)
 			{
-				return 1;
+				closesocket(sock);
+				return -1;
 			}
 
-			// Check if it's a valid IPv6 address
-			if (inet_pton(AF_INET6, ip.c_str(), &(sa6.sin6_addr)) == 1)
+			if (mUring != nullptr && mUring->ArmReceive(sock, SendType::MULTICAST) < 0)
 			{
-				return 2;
+				closesocket(sock);
+				mLastError = UdpClientError::READ_FAILED;
+				return -1;
 			}
 
-			return -1;  // Invalid IP address
+			size_t index = mSharedMulticastSockets.size();
+
+			if (RegisterListener(sock, SendType::MULTICAST, UDP_SHARED_LISTENER | index) < 0)
+			{
+				if (mUring != nullptr)
+				{
+					mUring->CancelReceive(sock);
+				}
+
+				mZeroCopyStates.erase(sock);
+				closesocket(sock);
+				return -1;
+			}
+
+			SharedMulticastSocket entry{};
+			entry.sock = sock;
+			entry.port = port;
+			mSharedMulticastSockets.push_back(entry);
+
+			return static_cast<int32_t>(index);
 		}
 
-		bool UDP_Client::ValidatePort(const int16_t port)
+		bool UDP_Client::IsSharedMulticastSocket(const SOCKET sock)
 		{
-			return (port >= 0 && port <= 65535);
+			for (const auto& i : mSharedMulticastSockets)
+			{
+				if (i.sock == sock)
+				{
+					return true;
+				}
+			}
+
+			return false;
 		}
 
+		size_t UDP_Client::LookupMulticastGroup(const in_addr group, const uint16_t port)
+		{
+			auto found = mMulticastGroupIndex.find(group.s_addr);
+
+			if (found != mMulticastGroupIndex.end())
+			{
+				// One entry per port the address was joined on, almost always just the one.
+				for (size_t index : found->second)
+				{
+					if (std::get<1>(mMulticastSockets[index]).sin_port == port)
+					{
+						return index;
+					}
+				}
+			}
+
+			return mMulticastSockets.size();
+		}
 	}
-}
\ No newline at end of file
+}
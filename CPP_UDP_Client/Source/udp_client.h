@@ -26,6 +26,15 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>						// Receive thread wait
+#if defined __linux__
+#include <sys/epoll.h>					// Listener event loop
+#include <netinet/udp.h>				// UDP_SEGMENT
+#include <linux/errqueue.h>				// Zero-copy completions
+#include <linux/filter.h>				// Classic BPF programs
+#include <linux/net_tstamp.h>			// Receive timestamp flags
+#include <pthread.h>					// Shard thread affinity
+#endif
 typedef int SOCKET;
 typedef struct sockaddr_in SOCKADDR_IN;
 typedef struct sockaddr SOCKADDR;
@@ -34,9 +43,21 @@ const int SOCKET_ERROR = -1;
 const int SD_BOTH = SHUT_RDWR;
 #define closesocket(s) close(s)
 #endif
+#include <algorithm>					// std::min
+#include <cstring>						// memset
+#include <functional>					// Listener callbacks
 #include <map>							// Error enum to strings.
 #include <string>						// Strings
 #include <regex>						// Regular expression for ip validation
+#include <span>							// Batched send and receive records
+#include <vector>						// Socket lists
+#include <tuple>						// Socket list entries
+#include <unordered_map>				// Multicast group index
+#include <thread>						// Receive thread
+#include <atomic>						// Receive thread stop flag
+#include <chrono>						// Receive thread back off
+#include <mutex>						// Queue delay histogram
+#include "udp_latency_histogram.h"		// Queue delay histogram
 //
 //	Defines:
 //          name                        reason defined
@@ -55,6 +76,13 @@ namespace Essentials
 		constexpr static uint8_t	UDP_CLIENT_VERSION_PATCH	= 0;
 		constexpr static uint8_t	UDP_CLIENT_VERSION_BUILD	= 0;
 		constexpr static uint8_t	UDP_DEFAULT_SOCKET_TIMEOUT	= 1;
+		constexpr static uint32_t	UDP_MAX_BATCH_SIZE			= 64;
+		constexpr static uint32_t	UDP_MAX_DATAGRAM_SIZE		= 65535;
+		constexpr static uint32_t	UDP_MAX_GSO_SEGMENTS		= 64;
+		constexpr static uint32_t	UDP_MAX_GSO_PAYLOAD			= 65507;
+		constexpr static uint32_t	UDP_MAX_GROUPS_PER_SOCKET	= 20;
+		constexpr static uint32_t	UDP_MAX_GATHER_BUFFERS		= 32;
+		constexpr static uint32_t	UDP_SHARD_DEFAULT_SLOT_SIZE	= 2048;
 
 		static std::string UdpClientVersion = "UDP Client v" +
 			std::to_string((uint8_t)UDP_CLIENT_VERSION_MAJOR) + "." +
@@ -103,6 +131,16 @@ namespace Essentials
 			MULTICAST_INTERFACE_ERROR,
 			MULTICAST_BIND_FAILED,
 			MULTICAST_SET_TTL_FAILED,
+			EVENT_LOOP_FAILED,
+			IO_URING_NOT_ENABLED,
+			SOCKET_OPTION_FAILED,
+			FEATURE_NOT_SUPPORTED,
+			RECEIVE_THREAD_FAILED,
+			SHARDED_RECEIVE_FAILED,
+			BUFFER_POOL_EXHAUSTED,
+			PIN_PEER_FAILED,
+			SEND_QUEUE_FULL,
+			SEND_QUEUE_PENDING,
 		};
 
 		/// <summary>Error enum to string map</summary>
@@ -132,6 +170,28 @@ namespace Essentials
 			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::SEND_FAILED) + ": Send failed.")},
 			{UdpClientError::READ_FAILED,
 			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::READ_FAILED) + ": Read failed.")},
+			{UdpClientError::SET_DESTINATION_FAILED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::SET_DESTINATION_FAILED) + ": Set destination failed.")},
+			{UdpClientError::EVENT_LOOP_FAILED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::EVENT_LOOP_FAILED) + ": Listener event loop failed.")},
+			{UdpClientError::IO_URING_NOT_ENABLED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::IO_URING_NOT_ENABLED) + ": io_uring backend not enabled.")},
+			{UdpClientError::SOCKET_OPTION_FAILED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::SOCKET_OPTION_FAILED) + ": Failed to set socket option.")},
+			{UdpClientError::FEATURE_NOT_SUPPORTED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::FEATURE_NOT_SUPPORTED) + ": Feature not supported on this platform.")},
+			{UdpClientError::RECEIVE_THREAD_FAILED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::RECEIVE_THREAD_FAILED) + ": Receive thread failed to start.")},
+			{UdpClientError::SHARDED_RECEIVE_FAILED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::SHARDED_RECEIVE_FAILED) + ": Sharded receive failed to start.")},
+			{UdpClientError::BUFFER_POOL_EXHAUSTED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::BUFFER_POOL_EXHAUSTED) + ": Every pooled buffer is in use.")},
+			{UdpClientError::PIN_PEER_FAILED,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::PIN_PEER_FAILED) + ": Failed to pin the unicast peer.")},
+			{UdpClientError::SEND_QUEUE_FULL,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::SEND_QUEUE_FULL) + ": Send queue is full or the datagram is larger than a queue slot.")},
+			{UdpClientError::SEND_QUEUE_PENDING,
+			std::string("Error Code " + std::to_string((uint8_t)UdpClientError::SEND_QUEUE_PENDING) + ": Queued datagrams must be sent first.")},
 		};
 
 		/// <summary>Represents an endpoint for a connection</summary>
@@ -141,6 +201,114 @@ namespace Essentials
 			int16_t	port = 0;
 		};
 
+		/// <summary>A destination resolved once up front, sends to it do no string parsing or allocation</summary>
+		struct Destination
+		{
+			sockaddr_in			address		= {};		// Resolved address and port, network byte order, family unset while unresolved
+
+			/// <summary>True once the destination has been resolved</summary>
+			bool IsResolved() const { return address.sin_family == AF_INET; }
+		};
+
+		/// <summary>Represents one datagram of a batched unicast send</summary>
+		struct UdpSendRecord
+		{
+			const char*			buffer		= nullptr;	// Data to be sent
+			uint32_t			size		= 0;		// Number of bytes to be sent
+			const sockaddr_in*	destination	= nullptr;	// Pre-resolved destination, nullptr sends to the unicast destination
+			int32_t				result		= -1;		// -[out]- Number of bytes sent, -1 if this datagram was not sent
+		};
+
+		/// <summary>Represents one caller-provided slot of a batched unicast receive</summary>
+		struct UdpReceiveSlot
+		{
+			void*				buffer		= nullptr;	// Buffer to place received data into
+			uint32_t			maxSize		= 0;		// Size of the buffer
+			uint32_t			length		= 0;		// -[out]- Number of bytes received
+			sockaddr_in			source		= {};		// -[out]- Address and port of the sender, network byte order
+			bool				truncated	= false;	// -[out]- True if the datagram was larger than the buffer
+			uint32_t			drops		= 0;		// -[out]- Socket's running kernel drop count when this datagram was queued, needs EnableDropAccounting
+			uint64_t			timestamp	= 0;		// -[out]- Kernel arrival time in nanoseconds since the epoch, needs EnableReceiveTimestamps
+			uint64_t			hardwareTimestamp = 0;	// -[out]- NIC arrival time in nanoseconds on the NIC clock, 0 unless the NIC stamps receives
+		};
+
+		/// <summary>A coalesced receive, iterating it yields each datagram in place as a span</summary>
+		struct CoalescedDatagrams
+		{
+			/// <summary>Walks the datagrams of a coalesced receive without copying them</summary>
+			class Iterator
+			{
+			public:
+				Iterator(const char* position, const char* end, const uint32_t segmentSize)
+					: mPosition(position), mEnd(end), mSegmentSize(segmentSize) {}
+
+				std::span<const char> operator*() const
+				{
+					return std::span<const char>(mPosition, std::min<size_t>(mSegmentSize, mEnd - mPosition));
+				}
+
+				Iterator& operator++()
+				{
+					mPosition += std::min<size_t>(mSegmentSize, mEnd - mPosition);
+					return *this;
+				}
+
+				bool operator!=(const Iterator& other) const { return mPosition != other.mPosition; }
+
+			private:
+				const char*		mPosition;
+				const char*		mEnd;
+				uint32_t		mSegmentSize;
+			};
+
+			const char*			data		= nullptr;	// Start of the coalesced buffer
+			uint32_t			size		= 0;		// Number of bytes received
+			uint16_t			segmentSize	= 0;		// Size of every datagram but the last, 0 if the receive was not coalesced
+			sockaddr_in			source		= {};		// Address and port of the sender, network byte order
+			bool				truncated	= false;	// True if the receive was larger than the buffer, the datagrams past size are lost
+			uint64_t			timestamp	= 0;		// Kernel arrival time of the first datagram in nanoseconds since the epoch, needs EnableReceiveTimestamps
+			uint32_t			drops		= 0;		// Socket's running kernel drop count when this run was queued, needs EnableDropAccounting
+
+			Iterator begin() const { return Iterator(data, data + size, segmentSize > 0 ? segmentSize : size); }
+			Iterator end() const { return Iterator(data + size, data + size, segmentSize > 0 ? segmentSize : size); }
+
+			/// <summary>Number of datagrams held by this receive</summary>
+			uint32_t Count() const { return segmentSize > 0 ? (size + segmentSize - 1) / segmentSize : (size > 0 ? 1 : 0); }
+		};
+
+		/// <summary>Identifies a buffer handed to a zero-copy send, the buffer must not change until it is released</summary>
+		struct ZeroCopyHandle
+		{
+			SOCKET				socket		= INVALID_SOCKET;	// Socket the buffer was sent on
+			uint32_t			sequence	= 0;				// Kernel completion sequence of the send
+		};
+
+		/// <summary>Represents a run of zero-copy sends the kernel has finished with</summary>
+		struct ZeroCopyCompletion
+		{
+			SOCKET				socket		= INVALID_SOCKET;	// Socket the sends were made on
+			uint32_t			first		= 0;				// Sequence of the first completed send
+			uint32_t			last		= 0;				// Sequence of the last completed send
+			bool				copied		= false;			// True if the kernel fell back to copying the data
+		};
+
+		/// <summary>Callback invoked for each run of completed zero-copy sends</summary>
+		using ZeroCopyCallback = std::function<void(const ZeroCopyCompletion& completion)>;
+
+		/// <summary>Callback invoked when the send queue depth reaches the high-water mark, and again once it drains to half of it</summary>
+		using SendQueueCallback = std::function<void(const uint32_t depth, const bool aboveHighWater)>;
+
+		/// <summary>How the kernel spreads datagrams across sharded receive sockets</summary>
+		enum class ShardSteering : uint8_t
+		{
+			KERNEL_HASH,		// Default SO_REUSEPORT flow hash
+			INCOMING_CPU,		// SO_INCOMING_CPU hint for each shard's cpu, flow hash where the kernel ignores it
+			CPU_BPF,			// Classic BPF reuseport program picking the shard of the receiving cpu
+		};
+
+		/// <summary>Callback invoked on a shard's worker thread for each datagram it receives</summary>
+		using ShardCallback = std::function<void(const uint32_t shard, const UdpReceiveSlot& datagram)>;
+
 		/// <summary>Send Type for the Send Function.</summary>
 		enum class SendType : uint8_t
 		{
@@ -149,6 +317,49 @@ namespace Essentials
 			MULTICAST,
 		};
 
+		/// <summary>One classic BPF instruction, laid out like the kernel's sock_filter</summary>
+		struct SocketFilterInstruction
+		{
+			uint16_t			code		= 0;		// Operation
+			uint8_t				jt			= 0;		// Instructions to skip when a jump is taken
+			uint8_t				jf			= 0;		// Instructions to skip when a jump is not taken
+			uint32_t			k			= 0;		// Operand
+		};
+
+		/// <summary>Handle to a joined multicast group, see UDP_Client::GetMulticastGroupId</summary>
+		using MulticastGroupId = uint32_t;
+
+		/// <summary>Pieces of one datagram sent back to back without joining them first, such as a header and a payload</summary>
+		using GatherBuffers = std::span<const std::span<const char>>;
+
+		/// <summary>I/O backend used for the receive path, sends always use the socket calls</summary>
+		enum class IoBackend : uint8_t
+		{
+			POSIX,
+			IO_URING,
+		};
+
+		class UDP_Uring;
+		struct UringPacket;
+		class UDP_PacketRing;
+		class UDP_BufferPool;
+		class PacketBuffer;
+		class UDP_SocketFilter;
+
+		/// <summary>Represents a datagram dispatched by UDP_Client::PollListeners</summary>
+		struct ListenerDatagram
+		{
+			SendType			type		= SendType::BROADCAST;	// Kind of listener the datagram arrived on
+			const sockaddr_in*	listener	= nullptr;				// Listener address, the bound port for broadcast or the group for multicast, only valid during the callback
+			sockaddr_in			sender		= {};					// Address and port of the sender, network byte order
+			const char*			data		= nullptr;				// Received data, only valid during the callback
+			int32_t				size		= 0;					// Number of bytes received
+			uint64_t			timestamp	= 0;					// Kernel arrival time in nanoseconds since the epoch, needs EnableReceiveTimestamps
+		};
+
+		/// <summary>Callback invoked for each datagram received on a listener</summary>
+		using ListenerCallback = std::function<void(const ListenerDatagram& datagram)>;
+
 		/// <summary>A multi-platform class to handle UDP communications.</summary>
 		class UDP_Client
 		{
@@ -159,6 +370,14 @@ namespace Essentials
 			/// <summary>Constructor to receive an address and port</summary>
 			UDP_Client(const std::string& clientsAddress, const int16_t clientsPort);
 
+			/// <summary>Constructor to select the I/O backend, falls back to POSIX if io_uring or its multishot receives
+			/// (linux 6.0) are not available. With io_uring every socket keeps a multishot receive posted, and received
+			/// datagrams are only delivered through TakePackets, which also reports a receive that failed. Sends keep 
+			/// using sendto and may run on any thread. The ring is not locked, so TakePackets, ReleasePacket and 
+			/// anything that opens or closes a socket (each arms or cancels its receive) must run on one thread at a time.</summary>
+			/// <param name="backend"> -[in]- Backend to use for receives</param>
+			explicit UDP_Client(const IoBackend backend);
+
 			/// <summary>Default Deconstructor</summary>
 			~UDP_Client();
 
@@ -174,6 +393,20 @@ namespace Essentials
 			/// <returns>0 if successful, -1 if fails. Call Serial::GetLastError to find out more.</returns>
 			int8_t SetUnicastDestination(const std::string& address, const int16_t port);
 
+			/// <summary>Connects the unicast socket to the unicast destination. While pinned the kernel keeps the route
+			/// cached, SendUnicast and ReceiveUnicast use send and recv, and datagrams from any other source are dropped.
+			/// Changing the unicast destination re-pins to the new peer.</summary>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t PinUnicastPeer();
+
+			/// <summary>Disconnects the unicast socket so it sends and receives to and from any peer again</summary>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t UnpinUnicastPeer();
+
+			/// <summary>Check if the unicast socket is pinned to its destination</summary>
+			/// <returns>true if pinned, false if not</returns>
+			bool IsUnicastPeerPinned();
+
 			/// <summary>A function to enable broadcasting</summary>
 			/// <param name="port"> -[in]- Port to broadcast on</param>
 			//// <returns>0 if successful, -1 if fails. Call Serial::GetLastError to find out more.</returns>
@@ -204,6 +437,102 @@ namespace Essentials
 			/// <returns>0 if successful, -1 if fails. Call Serial::GetLastError to find out more.</returns>
 			int8_t AddMulticastGroup(const std::string& groupIP, const int16_t port);
 
+			/// <summary>Add a multicast group that only delivers traffic from the listed sources (IGMPv3 source-specific join).
+			/// Other publishers to the group are filtered in the kernel and never reach the socket.</summary>
+			/// <param name="groupIP"> -[in]- Address of multicast group.</param>
+			/// <param name="port"> -[in]- Port of multicast group.</param>
+			/// <param name="sources"> -[in]- IPv4 addresses of the sources to accept, empty joins for every source</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t AddMulticastGroup(const std::string& groupIP, const int16_t port, const std::vector<std::string>& sources);
+
+			/// <summary>Joins groups added afterwards on a few shared sockets per port instead of one socket each. Datagrams
+			/// are told apart by their destination group (IP_PKTINFO), so receive cost does not grow with the number of groups.
+			/// A new socket is opened for a port every UDP_MAX_GROUPS_PER_SOCKET groups, the kernel's default membership limit, 
+			/// or sooner if a join fails for lack of room (ENOBUFS). Not available on a client using the io_uring engine, whose packets do not carry the destination group.</summary>
+			/// <param name="enable"> -[in]- True to share sockets between groups, false to give each group its own socket</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t SetSharedMulticastSockets(const bool enable);
+
+			/// <summary>Attaches a socket filter to every socket of a kind, and to each one opened later, so rejected 
+			/// datagrams are dropped in the kernel before they are queued or copied. Replaces any filter already attached.</summary>
+			/// <param name="type"> -[in]- Kind of sockets to filter, unicast includes the shard sockets</param>
+			/// <param name="filter"> -[in]- Filter to attach</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t AttachFilter(const SendType type, const UDP_SocketFilter& filter);
+
+			/// <summary>Removes the socket filter from every socket of a kind</summary>
+			/// <param name="type"> -[in]- Kind of sockets to stop filtering</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t DetachFilter(const SendType type);
+
+			/// <summary>Sets the kernel buffer sizes of every socket of a kind, and of each one opened later. Privileged processes
+			/// go past the system maximum (SO_RCVBUFFORCE and SO_SNDBUFFORCE on linux), others are capped by it.</summary>
+			/// <param name="type"> -[in]- Kind of sockets to size, unicast includes the shard sockets</param>
+			/// <param name="receiveBytes"> -[in]- Receive buffer size, 0 leaves it unchanged</param>
+			/// <param name="sendBytes"> -[in]- Send buffer size, 0 leaves it unchanged</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t SetSocketBufferSizes(const SendType type, const int32_t receiveBytes, const int32_t sendBytes);
+
+			/// <summary>Reads back the buffer sizes the kernel granted the first socket of a kind. Linux reports twice the 
+			/// requested size, the extra half covers its own bookkeeping.</summary>
+			/// <param name="type"> -[in]- Kind of socket</param>
+			/// <param name="receiveBytes"> -[out]- Receive buffer size</param>
+			/// <param name="sendBytes"> -[out]- Send buffer size</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t GetSocketBufferSizes(const SendType type, int32_t& receiveBytes, int32_t& sendBytes);
+
+			/// <summary>Enables or disables kernel drop accounting (SO_RXQ_OVFL) on every socket, and on each one opened later.
+			/// Batched and coalesced unicast receives then report the socket's running drop count with each datagram, every other 
+			/// receive but the io_uring engine records it for GetKernelDropCounts.</summary>
+			/// <param name="enable"> -[in]- True to report drops, false to stop</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t EnableDropAccounting(const bool enable);
+
+			/// <summary>Enables or disables departure times (SO_TXTIME, CLOCK_MONOTONIC) on the unicast and multicast sockets, and on 
+			/// each one opened later. The times given to SendUnicastAt and SendMulticastToGroupAt are only honoured when the 
+			/// interface runs the fq or etf qdisc, any other qdisc sends at once.</summary>
+			/// <param name="enable"> -[in]- True to honour departure times, false to stop</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t EnableTransmitTime(const bool enable);
+
+			/// <summary>Check if departure times are being handed to the kernel</summary>
+			/// <returns>true if SO_TXTIME is enabled, false if not</returns>
+			bool IsTransmitTimeEnabled();
+
+			/// <summary>Get the unicast socket's kernel drop count, as of the last batched receive</summary>
+			/// <returns>Number of datagrams the kernel dropped because the receive buffer was full</returns>
+			uint32_t GetKernelDropCount();
+
+			/// <summary>Get the kernel drop count of every open socket that has reported one, as of its last receive. Covers the 
+			/// batched, ring, shard and listener receives, the count only arrives once a socket has dropped something.</summary>
+			/// <returns>Running drop count per socket</returns>
+			std::unordered_map<SOCKET, uint32_t> GetKernelDropCounts();
+
+			/// <summary>Enables or disables kernel receive timestamps (SO_TIMESTAMPNS) on every socket, open now or later. The batched, 
+			/// pooled, ring, shard and listener receives then report each datagram's arrival time and feed the queue delay histogram. 
+			/// The coalesced receive stamps each run with its first datagram's arrival. The io_uring engine and the single datagram 
+			/// ReceiveUnicast, ReceiveBroadcast and ReceiveMulticast do not read timestamps, so their datagrams carry none and are 
+			/// left out of the histogram.</summary>
+			/// <param name="enable"> -[in]- True to enable timestamps</param>
+			/// <param name="hardware"> -[in]- True to ask for NIC timestamps through SO_TIMESTAMPING as well, falls back to software 
+			/// timestamps if the socket refuses. The NIC itself must have receive stamping turned on (SIOCSHWTSTAMP).</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t EnableReceiveTimestamps(const bool enable, const bool hardware = false);
+
+			/// <summary>Get a copy of the queue delay histogram, the time each datagram waited in its socket between 
+			/// kernel arrival and being received by the application</summary>
+			/// <returns>Histogram of queue delays in nanoseconds</returns>
+			LatencyHistogram GetQueueDelayHistogram();
+
+			/// <summary>Clears the queue delay histogram</summary>
+			void ResetQueueDelayHistogram();
+
+			/// <summary>Enables or disables kernel receive coalescing (UDP_GRO) on the unicast socket. Applied immediately if the 
+			/// socket is open, else when OpenUnicast is called. Coalesced datagrams should be read with ReceiveUnicastCoalesced.</summary>
+			/// <param name="enable"> -[in]- True to coalesce, false for one datagram per receive</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t SetReceiveCoalescing(const bool enable);
+
 			/// <summary>Opens the UDP unicast socket and binds it to the set address and port</summary>
 			/// <returns>0 if successful, -1 if fails. Call Serial::GetLastError to find out more.</returns>
 			int8_t OpenUnicast();
@@ -226,12 +555,143 @@ namespace Essentials
 			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
 			int8_t SendUnicast(const char* buffer, const uint32_t size, const std::string& ipAddress, const int16_t port);
 
+			/// <summary>Send a unicast message to a pre-resolved destination</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="destination"> -[in]- Destination filled by ResolveDestination</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendUnicast(const char* buffer, const uint32_t size, const Destination& destination);
+
+			/// <summary>Send a unicast message gathered from several buffers (sendmsg), no copy is made to join them</summary>
+			/// <param name="buffers"> -[in]- Pieces of the datagram in order, at most UDP_MAX_GATHER_BUFFERS</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendUnicast(GatherBuffers buffers);
+
+			/// <summary>Send a unicast message gathered from several buffers to a pre-resolved destination</summary>
+			/// <param name="buffers"> -[in]- Pieces of the datagram in order, at most UDP_MAX_GATHER_BUFFERS</param>
+			/// <param name="destination"> -[in]- Destination filled by ResolveDestination</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendUnicast(GatherBuffers buffers, const Destination& destination);
+
+			/// <summary>Send a unicast message that the kernel holds back until a departure time, needs EnableTransmitTime</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="destination"> -[in]- Destination filled by ResolveDestination</param>
+			/// <param name="departure"> -[in]- Departure time in nanoseconds of std::chrono::steady_clock</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendUnicastAt(const char* buffer, const uint32_t size, const Destination& destination, const uint64_t departure);
+
+			/// <summary>Resolves an ip and port once so repeated sends to it skip parsing. The sockets are IPv4 only, 
+			/// an IPv6 address fails with ADDRESS_NOT_SUPPORTED.</summary>
+			/// <param name="ipAddress"> -[in]- IPv4 address of the destination</param>
+			/// <param name="port"> -[in]- Port of the destination</param>
+			/// <param name="destination"> -[out]- Resolved destination</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t ResolveDestination(const std::string& ipAddress, const int16_t port, Destination& destination);
+
+			/// <summary>Send a batch of unicast messages with as few system calls as possible (sendmmsg on linux)</summary>
+			/// <param name="records"> -[in/out]- Datagrams to be sent, each record's result is filled with its number of bytes sent</param>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendUnicastBatch(std::span<UdpSendRecord> records);
+
+			/// <summary>Send a batch of unicast messages without touching GetLastError, so several threads may send on the 
+			/// unicast socket at once</summary>
+			/// <param name="records"> -[in/out]- Datagrams to be sent, each record's result is filled with its number of bytes sent</param>
+			/// <param name="errorCode"> -[out]- System error (errno, WSAGetLastError on windows) of the first record not sent, 
+			/// EWOULDBLOCK if the send buffer was full or the send queue still holds datagrams, 0 if every record was sent or the 
+			/// kernel stopped without a reason</param>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if the first record failed for any reason but a full send buffer.</returns>
+			int32_t SendUnicastBatch(std::span<UdpSendRecord> records, int32_t& errorCode);
+
+			/// <summary>Sends a large buffer as a run of segmentSize datagrams, letting the kernel split it (UDP_SEGMENT on linux). 
+			/// Falls back to batched sends of each segment when segmentation offload is not available.</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="segmentSize"> -[in]- Size of each datagram, the last one may be shorter, at most UDP_MAX_GSO_PAYLOAD</param>
+			/// <param name="destination"> -[in/opt]- Pre-resolved destination, nullptr sends to the unicast destination</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendUnicastSegmented(const char* buffer, const uint32_t size, const uint16_t segmentSize, const sockaddr_in* destination = nullptr);
+
+			/// <summary>Enables or disables zero-copy sends (SO_ZEROCOPY on linux) on the unicast and multicast sockets</summary>
+			/// <param name="enable"> -[in]- True to allow zero-copy sends</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t EnableZeroCopy(const bool enable);
+
+			/// <summary>Send a unicast message without copying it into the kernel. The buffer must stay untouched until 
+			/// IsBufferReleased returns true for the handle, see PollZeroCopyCompletions.</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="handle"> -[out]- Handle used to find out when the buffer can be reused</param>
+			/// <param name="destination"> -[in/opt]- Pre-resolved destination, nullptr sends to the unicast destination</param>
+			/// <returns>0+ if successful (number bytes sent, 0 if the kernel is out of notification memory), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendUnicastZeroCopy(const char* buffer, const uint32_t size, ZeroCopyHandle& handle, const sockaddr_in* destination = nullptr);
+
+			/// <summary>Send a multicast message to one joined group without copying it into the kernel. The buffer must 
+			/// stay untouched until IsBufferReleased returns true for the handle, see PollZeroCopyCompletions.</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="groupIP"> -[in]- IP of the group to send to</param>
+			/// <param name="handle"> -[out]- Handle used to find out when the buffer can be reused</param>
+			/// <returns>0+ if successful (number bytes sent, 0 if the kernel is out of notification memory), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendMulticastZeroCopy(const char* buffer, const uint32_t size, const std::string& groupIP, ZeroCopyHandle& handle);
+
+			/// <summary>Sets the callback that PollZeroCopyCompletions reports completed sends to</summary>
+			/// <param name="callback"> -[in]- Function to call for each run of completed sends</param>
+			void SetZeroCopyCallback(ZeroCopyCallback callback);
+
+			/// <summary>Reads zero-copy completions from the socket error queues without blocking</summary>
+			/// <returns>0+ if successful (number of sends completed), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t PollZeroCopyCompletions();
+
+			/// <summary>Checks if the kernel is done with the buffer of a zero-copy send, as of the last PollZeroCopyCompletions</summary>
+			/// <param name="handle"> -[in]- Handle returned by the zero-copy send</param>
+			/// <returns>true if the buffer can be reused or freed, else false</returns>
+			bool IsBufferReleased(const ZeroCopyHandle& handle);
+
+			/// <summary>Enables the unicast send queue. Once enabled, a SendUnicast that finds the socket buffer full queues the 
+			/// datagram instead of failing, and later sends queue behind it so order is kept. SendUnicastAt, SendUnicastBatch, 
+			/// SendUnicastSegmented and SendUnicastZeroCopy are never queued, they drain the queue first and fail with 
+			/// SEND_QUEUE_PENDING while datagrams still wait. The queue is drained by each send, by PollSendQueue, and on linux by 
+			/// PollListeners, which watches the socket for room (EPOLLOUT) while the queue is not empty.</summary>
+			/// <param name="slotCount"> -[in]- Number of datagrams the queue holds, rounded up to a power of two, 0 disables and discards the queue</param>
+			/// <param name="slotSize"> -[in]- Largest datagram the queue holds</param>
+			/// <param name="highWaterMark"> -[in]- Depth at which the send queue callback is invoked, 0 for three quarters of the queue</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t EnableSendQueue(const uint32_t slotCount, const uint32_t slotSize, const uint32_t highWaterMark = 0);
+
+			/// <summary>Sets the callback invoked when the send queue crosses its high-water mark</summary>
+			/// <param name="callback"> -[in]- Function to call with the depth and whether it is above the mark, called on the sending 
+			/// or draining thread with no lock held</param>
+			void SetSendQueueCallback(SendQueueCallback callback);
+
+			/// <summary>Get the number of datagrams waiting in the send queue</summary>
+			/// <returns>Number of queued datagrams, 0 if the queue is not enabled</returns>
+			uint32_t GetSendQueueDepth();
+
+			/// <summary>Get the number of queued datagrams dropped because the socket refused them, each drop also set GetLastError</summary>
+			/// <returns>Number of datagrams dropped since the queue was enabled</returns>
+			uint64_t GetSendQueueDropCount();
+
+			/// <summary>Get the number of datagrams the send queue can hold</summary>
+			/// <returns>Capacity of the queue, 0 if the queue is not enabled</returns>
+			uint32_t GetSendQueueCapacity();
+
+			/// <summary>Waits for the unicast socket to become writable and drains the send queue into it</summary>
+			/// <param name="timeoutMSecs"> -[in]- Maximum number of milliseconds to wait, 0 does not wait, -1 waits forever</param>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t PollSendQueue(const int32_t timeoutMSecs);
+
 			/// <summary>Send a broadcast message</summary>
 			/// <param name="buffer"> -[in]- Buffer to be sent</param>
 			/// <param name="size"> -[in]- Size to be sent</param>
 			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
 			int8_t SendBroadcast(const char* buffer, const uint32_t size);
 
+			/// <summary>Send a broadcast message gathered from several buffers (sendmsg)</summary>
+			/// <param name="buffers"> -[in]- Pieces of the datagram in order, at most UDP_MAX_GATHER_BUFFERS</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendBroadcast(GatherBuffers buffers);
+
 			/// <summary>Send a multicast message to all joined groups</summary>
 			/// <param name="buffer"> -[in]- Buffer to be sent</param>
 			/// <param name="size"> -[in]- Size to be sent</param>
@@ -239,6 +699,40 @@ namespace Essentials
 			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
 			int8_t SendMulticast(const char* buffer, const uint32_t size, const std::string& groupIP = "");
 
+			/// <summary>Send a multicast message gathered from several buffers (sendmsg) to all joined groups</summary>
+			/// <param name="buffers"> -[in]- Pieces of the datagram in order, at most UDP_MAX_GATHER_BUFFERS</param>
+			/// <param name="groupIP"> -[in/opt]- IP of group to send to if only sending to one desired group</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendMulticast(GatherBuffers buffers, const std::string& groupIP = "");
+
+			/// <summary>Send a multicast message to one joined group without looking it up</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="id"> -[in]- Group id from GetMulticastGroupId</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendMulticastToGroup(const char* buffer, const uint32_t size, const MulticastGroupId id);
+
+			/// <summary>Send a multicast message gathered from several buffers to one joined group</summary>
+			/// <param name="buffers"> -[in]- Pieces of the datagram in order, at most UDP_MAX_GATHER_BUFFERS</param>
+			/// <param name="id"> -[in]- Group id from GetMulticastGroupId</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendMulticastToGroup(GatherBuffers buffers, const MulticastGroupId id);
+
+			/// <summary>Send a multicast message to one joined group that the kernel holds back until a departure time, needs EnableTransmitTime</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="id"> -[in]- Group id from GetMulticastGroupId</param>
+			/// <param name="departure"> -[in]- Departure time in nanoseconds of std::chrono::steady_clock</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendMulticastToGroupAt(const char* buffer, const uint32_t size, const MulticastGroupId id, const uint64_t departure);
+
+			/// <summary>Get the id of a joined group, valid until multicast is disabled</summary>
+			/// <param name="groupIP"> -[in]- Address of the group</param>
+			/// <param name="port"> -[in]- Port of the group</param>
+			/// <param name="id"> -[out]- Id of the group</param>
+			/// <returns>0 if successful, -1 if the group is not joined. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t GetMulticastGroupId(const std::string& groupIP, const int16_t port, MulticastGroupId& id);
+
 			/// <summary>Receive data from a server</summary>
 			/// <param name="buffer"> -[out]- Buffer to place received data into</param>
 			/// <param name="maxSize"> -[in]- Maximum number of bytes to be read</param>
@@ -253,6 +747,53 @@ namespace Essentials
 			/// <returns>0+ if successful (number bytes received), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
 			int8_t ReceiveUnicast(void* buffer, const uint32_t maxSize, std::string& recvFromAddr, int16_t& recvFromPort);
 
+			/// <summary>Receive a run of datagrams the kernel coalesced from one sender (UDP_GRO on linux). 
+			/// Requires SetReceiveCoalescing, otherwise each receive holds a single datagram. Fails rather than hand back a 
+			/// run whose segment size the kernel could not report.</summary>
+			/// <param name="buffer"> -[out]- Buffer to place received data into, UDP_MAX_DATAGRAM_SIZE holds any coalesced receive</param>
+			/// <param name="maxSize"> -[in]- Maximum number of bytes to be read</param>
+			/// <param name="datagrams"> -[out]- The received buffer, its segment size and whether it was truncated, iterate it for each datagram</param>
+			/// <returns>0+ if successful (number bytes received), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t ReceiveUnicastCoalesced(void* buffer, const uint32_t maxSize, CoalescedDatagrams& datagrams);
+
+			/// <summary>Receive a batch of unicast messages with as few system calls as possible (recvmmsg on linux)</summary>
+			/// <param name="slots"> -[in/out]- Slots to place received datagrams into, filled in order</param>
+			/// <returns>0+ if successful (number of slots filled), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t ReceiveUnicastBatch(std::span<UdpReceiveSlot> slots);
+
+			/// <summary>Receive a unicast message into a buffer taken from a pool. Broadcast and multicast listeners have no 
+			/// pooled receive, PollListeners is their zero-allocation path.</summary>
+			/// <param name="pool"> -[in]- Pool to take the buffer from</param>
+			/// <param name="packet"> -[out]- Handle to the filled buffer, empty if nothing was received</param>
+			/// <returns>0+ if successful (number bytes received), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t ReceiveUnicast(UDP_BufferPool& pool, PacketBuffer& packet);
+
+			/// <summary>Receive a batch of unicast messages into buffers taken from a pool</summary>
+			/// <param name="pool"> -[in]- Pool to take the buffers from</param>
+			/// <param name="packets"> -[out]- Handles to fill in order, unfilled handles are left empty</param>
+			/// <returns>0+ if successful (number of packets filled), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t ReceiveUnicastBatch(UDP_BufferPool& pool, std::span<PacketBuffer> packets);
+
+			/// <summary>Sets the spin budget of the busy-poll receives. The unicast socket also gets SO_BUSY_POLL and 
+			/// SO_PREFER_BUSY_POLL so the kernel polls the device queue while we spin; raising SO_BUSY_POLL above 
+			/// net.core.busy_read needs CAP_NET_ADMIN, without it only the spin in user space applies.</summary>
+			/// <param name="spinMicroseconds"> -[in]- Time to spin on the socket before sleeping, 0 never spins</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t SetBusyPoll(const uint32_t spinMicroseconds);
+
+			/// <summary>Receive a unicast message, spinning on the socket for the busy-poll budget before sleeping in poll</summary>
+			/// <param name="buffer"> -[out]- Buffer to place received data into</param>
+			/// <param name="maxSize"> -[in]- Maximum number of bytes to be read</param>
+			/// <param name="timeoutMSecs"> -[in]- Maximum number of milliseconds to sleep once the spin is spent, -1 waits forever</param>
+			/// <returns>0+ if successful (number bytes received, 0 on timeout), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t ReceiveUnicastSpin(void* buffer, const uint32_t maxSize, const int32_t timeoutMSecs);
+
+			/// <summary>Receive a batch of unicast messages, spinning on the socket for the busy-poll budget before sleeping in poll</summary>
+			/// <param name="slots"> -[in/out]- Slots to place received datagrams into, filled in order</param>
+			/// <param name="timeoutMSecs"> -[in]- Maximum number of milliseconds to sleep once the spin is spent, -1 waits forever</param>
+			/// <returns>0+ if successful (number of slots filled, 0 on timeout), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t ReceiveUnicastBatchSpin(std::span<UdpReceiveSlot> slots, const int32_t timeoutMSecs);
+
 			/// <summary>Receive a broadcast message</summary>
 			/// <param name="buffer"> -[out]- Buffer to place received data into</param>
 			/// <param name="maxSize"> -[in]- Maximum number of bytes to be read</param>
@@ -280,6 +821,66 @@ namespace Essentials
 			/// <returns>0+ if successful (number bytes received), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
 			int8_t ReceiveMulticast(void* buffer, const uint32_t maxSize, std::string& multicastGroup);
 
+			/// <summary>Sets the callback that PollListeners dispatches broadcast datagrams to</summary>
+			/// <param name="callback"> -[in]- Function to call for each received broadcast datagram</param>
+			void SetBroadcastCallback(ListenerCallback callback);
+
+			/// <summary>Sets the callback that PollListeners dispatches multicast datagrams to</summary>
+			/// <param name="callback"> -[in]- Function to call for each received multicast datagram</param>
+			void SetMulticastCallback(ListenerCallback callback);
+
+			/// <summary>Waits on every broadcast listener and multicast group at the same time (epoll on linux) and 
+			/// dispatches all waiting datagrams to the broadcast and multicast callbacks</summary>
+			/// <param name="timeoutMSecs"> -[in]- Maximum number of milliseconds to wait, -1 waits forever</param>
+			/// <returns>0+ if successful (number of datagrams dispatched), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t PollListeners(const int32_t timeoutMSecs);
+
+			/// <summary>Takes datagrams received on any socket out of the io_uring buffer ring without copying them</summary>
+			/// <param name="packets"> -[out]- Packets to be filled, each must be handed back with ReleasePacket</param>
+			/// <param name="timeoutMSecs"> -[in]- Maximum number of milliseconds to wait for the first packet, 0 does not wait</param>
+			/// <returns>0+ if successful (number of packets taken), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t TakePackets(std::span<UringPacket> packets, const int32_t timeoutMSecs);
+
+			/// <summary>Hands a packet taken with TakePackets back to the io_uring buffer ring</summary>
+			/// <param name="packet"> -[in]- Packet to be released</param>
+			void ReleasePacket(const UringPacket& packet);
+
+			/// <summary>Get the I/O backend in use</summary>
+			/// <returns>IoBackend::IO_URING if the io_uring engine is running, else IoBackend::POSIX</returns>
+			IoBackend GetIoBackend();
+
+			/// <summary>Starts a background thread that drains the unicast socket, broadcast listeners and multicast groups 
+			/// open at this time into a lock-free ring, read from one consumer thread through GetReceiveRing. Closing any of 
+			/// them stops the thread and restarts it on the sockets still open, the ring and its slots are kept. 
+			/// Not available with the io_uring backend, whose receives already run in the kernel.</summary>
+			/// <param name="slotCount"> -[in]- Number of packet slots, rounded up to a power of two</param>
+			/// <param name="slotSize"> -[in]- Size of each packet slot, larger datagrams are truncated</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t StartReceiveThread(const uint32_t slotCount, const uint32_t slotSize);
+
+			/// <summary>Stops the receive thread and frees its ring</summary>
+			void StopReceiveThread();
+
+			/// <summary>Get the ring filled by the receive thread. Poll it with ReadableCount, read with ReadableSlot and 
+			/// hand slots back with Consume; no locks or system calls are involved.</summary>
+			/// <returns>The ring, nullptr if the receive thread is not running</returns>
+			UDP_PacketRing* GetReceiveRing();
+
+			/// <summary>Starts a sharded unicast receiver: shardCount sockets bound to this client's address with SO_REUSEPORT, 
+			/// each drained by its own worker thread pinned to cpu (firstCpu + shard). The unicast socket must not be open, 
+			/// the kernel would not spread datagrams to it. Linux only.</summary>
+			/// <param name="shardCount"> -[in]- Number of sockets and worker threads</param>
+			/// <param name="callback"> -[in]- Function called on the worker thread for each received datagram</param>
+			/// <param name="steering"> -[in/opt]- How datagrams are spread across the shards</param>
+			/// <param name="firstCpu"> -[in/opt]- Cpu the first shard is pinned to, -1 leaves the threads unpinned</param>
+			/// <param name="slotSize"> -[in/opt]- Size of each of a worker's UDP_MAX_BATCH_SIZE receive slots, larger datagrams are truncated</param>
+			/// <returns>0 if successful, -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int8_t StartShardedReceive(const uint32_t shardCount, ShardCallback callback, const ShardSteering steering = ShardSteering::KERNEL_HASH, 
+				const int32_t firstCpu = 0, const uint32_t slotSize = UDP_SHARD_DEFAULT_SLOT_SIZE);
+
+			/// <summary>Stops the shard worker threads and closes their sockets</summary>
+			void StopShardedReceive();
+
 			/// <summary>Closes the unicast client and cleans up</summary>
 			void CloseUnicast();
 
@@ -323,6 +924,234 @@ namespace Essentials
 			/// <returns>true = valid, false = invalid</returns>
 			bool ValidatePort(const int16_t port);
 
+			/// <summary>Sends a datagram on a socket with sendto, on either I/O backend</summary>
+			/// <param name="sock"> -[in]- Socket to send on</param>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="destination"> -[in]- Destination of the datagram</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails.</returns>
+			int32_t SendTo(const SOCKET sock, const char* buffer, const uint32_t size, const sockaddr_in& destination);
+
+			/// <summary>Sends a datagram gathered from several buffers in one system call (sendmsg or WSASendTo)</summary>
+			/// <param name="sock"> -[in]- Socket to send on</param>
+			/// <param name="buffers"> -[in]- Pieces of the datagram in order</param>
+			/// <param name="destination"> -[in]- Destination of the datagram, nullptr for a connected socket</param>
+			/// <param name="length"> -[in]- Size of the destination address</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails.</returns>
+			int32_t SendGather(const SOCKET sock, GatherBuffers buffers, const sockaddr* destination, const int32_t length);
+
+			/// <summary>Sends a unicast datagram, queueing it if the socket buffer is full or others are already queued</summary>
+			/// <param name="buffers"> -[in]- Pieces of the datagram in order, joined into one slot if it is queued</param>
+			/// <param name="destination"> -[in]- Destination of the datagram</param>
+			/// <returns>0+ if successful (number bytes sent or queued), -1 if fails.</returns>
+			int32_t SendOrQueue(GatherBuffers buffers, const sockaddr_in& destination);
+
+			/// <summary>Sends queued datagrams until the queue is empty or the socket buffer is full, mSendQueueLock must be held</summary>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if a datagram failed, it is dropped from the queue.</returns>
+			int32_t DrainSendQueue();
+
+			/// <summary>Drains the send queue and invokes the high-water callback if the depth crossed it</summary>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if a datagram failed, it is dropped from the queue.</returns>
+			int32_t FlushSendQueue();
+
+			/// <summary>Readies a send that cannot be queued: drains the queue, then holds mSendQueueLock so nothing queues 
+			/// ahead of the send. Nothing is held when the queue is disabled.</summary>
+			/// <param name="lock"> -[out]- Holds mSendQueueLock on success while the queue is enabled</param>
+			/// <returns>0 if the send may go ahead, -1 if datagrams are still queued.</returns>
+			int8_t HoldSendQueue(std::unique_lock<std::mutex>& lock);
+
+			/// <summary>Adds or removes the unicast socket from the listener event loop's EPOLLOUT watch, mSendQueueLock must be held</summary>
+			/// <param name="watch"> -[in]- True while datagrams are queued</param>
+			void WatchSendQueue(const bool watch);
+
+			/// <summary>Sends a batch of unicast messages without checking the send queue or touching GetLastError</summary>
+			/// <param name="records"> -[in/out]- Datagrams to be sent</param>
+			/// <param name="errorCode"> -[out]- System error of the first record not sent, 0 if none</param>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if the first record failed for any reason but a full send buffer.</returns>
+			int32_t SendBatch(std::span<UdpSendRecord> records, int32_t& errorCode);
+
+			/// <summary>Works out whether the send queue has crossed its high-water mark, mSendQueueLock must be held</summary>
+			/// <param name="depth"> -[out]- Depth of the queue</param>
+			/// <returns>True if the callback should be invoked.</returns>
+			bool CheckHighWater(uint32_t& depth);
+
+			/// <summary>Sends a datagram on a socket with a departure time attached (SCM_TXTIME)</summary>
+			/// <param name="sock"> -[in]- Socket to send on</param>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="destination"> -[in]- Destination of the datagram</param>
+			/// <param name="length"> -[in]- Size of the destination address</param>
+			/// <param name="departure"> -[in]- Departure time in nanoseconds of CLOCK_MONOTONIC</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails.</returns>
+			int32_t SendAt(const SOCKET sock, const char* buffer, const uint32_t size, const sockaddr* destination, const int32_t length, const uint64_t departure);
+
+			/// <summary>Sends a datagram with MSG_ZEROCOPY and records its completion sequence</summary>
+			/// <param name="sock"> -[in]- Socket to send on</param>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="destination"> -[in]- Destination of the datagram</param>
+			/// <param name="handle"> -[out]- Handle for the send</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails.</returns>
+			int32_t SendZeroCopy(const SOCKET sock, const char* buffer, const uint32_t size, const sockaddr_in& destination, ZeroCopyHandle& handle);
+
+			/// <summary>Turns SO_ZEROCOPY on or off for one socket</summary>
+			/// <param name="sock"> -[in]- Socket to be configured</param>
+			/// <param name="enable"> -[in]- True to allow zero-copy sends</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t ConfigureZeroCopy(const SOCKET sock, const bool enable);
+
+			/// <summary>A socket drained by the receive thread, copied so the thread never reads the client's lists</summary>
+			struct ReceiveSocket
+			{
+				SOCKET										sock		= INVALID_SOCKET;		// Socket to drain
+				SendType									type		= SendType::UNICAST;	// Kind of socket
+				sockaddr_in									group		= {};					// Group of a single group multicast socket
+				bool										shared		= false;				// True if the group comes with each datagram
+			};
+
+			/// <summary>Get every open socket the receive thread should drain</summary>
+			/// <returns>The sockets, with the group of each multicast one</returns>
+			std::vector<ReceiveSocket> GetReceiveSockets();
+
+			/// <summary>Stops the receive thread and keeps its ring, so the thread can be resumed on other sockets</summary>
+			void PauseReceiveThread();
+
+			/// <summary>Restarts a paused receive thread on the sockets open now, if there are any</summary>
+			void ResumeReceiveThread();
+
+			/// <summary>Body of the receive thread, waits on every socket and fills the receive ring</summary>
+			/// <param name="sockets"> -[in]- Sockets to drain</param>
+			void ReceiveThreadLoop(const std::vector<ReceiveSocket> sockets);
+
+			/// <summary>Reads waiting datagrams from one socket straight into free receive ring slots</summary>
+			/// <param name="socket"> -[in]- Socket to read from</param>
+			/// <returns>Number of slots filled</returns>
+			uint32_t ReceiveIntoRing(const ReceiveSocket& socket);
+
+			/// <summary>Body of a shard worker thread, receives batches from one shard socket and hands them to the callback</summary>
+			/// <param name="shard"> -[in]- Index of the shard</param>
+			/// <param name="cpu"> -[in]- Cpu to pin the thread to, -1 to leave it unpinned</param>
+			/// <param name="slotSize"> -[in]- Size of each receive slot</param>
+			void ShardThreadLoop(const uint32_t shard, const int32_t cpu, const uint32_t slotSize);
+
+			/// <summary>Creates the listener event loop if it does not exist yet</summary>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t OpenListenerPoll();
+
+			/// <summary>Registers a listener socket with the listener event loop, creating the loop for the first listener</summary>
+			/// <param name="sock"> -[in]- Socket to be registered, the event loop identifies the listener by it</param>
+			/// <param name="type"> -[in]- Kind of listener</param>
+			/// <param name="index"> -[in]- Index the listener will have in its socket list</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t RegisterListener(const SOCKET sock, const SendType type, const size_t index);
+
+			/// <summary>Reads every waiting datagram from a listener socket and dispatches it to the matching callback</summary>
+			/// <param name="type"> -[in]- Kind of listener</param>
+			/// <param name="index"> -[in]- Index of the listener in its socket list</param>
+			/// <returns>0+ if successful (number of datagrams dispatched), -1 if fails.</returns>
+			int32_t DispatchListener(const SendType type, const size_t index);
+
+			/// <summary>Reads every waiting datagram from a shared multicast socket and dispatches each to its group's callback</summary>
+			/// <param name="shared"> -[in]- Index of the socket in mSharedMulticastSockets</param>
+			/// <returns>0+ if successful (number of datagrams dispatched), -1 if fails.</returns>
+			int32_t DispatchSharedMulticast(const size_t shared);
+
+			/// <summary>Receives one datagram from a shared multicast socket and finds the group it was sent to</summary>
+			/// <param name="shared"> -[in]- Index of the socket in mSharedMulticastSockets</param>
+			/// <param name="buffer"> -[out]- Buffer to place received data into</param>
+			/// <param name="maxSize"> -[in]- Maximum number of bytes to be read</param>
+			/// <param name="sender"> -[out]- Address and port of the sender</param>
+			/// <param name="group"> -[out]- Index of the group in mMulticastSockets, unchanged if it is not joined</param>
+			/// <param name="timestamp"> -[out]- Kernel arrival time, 0 unless receive timestamps are enabled</param>
+			/// <returns>0+ if successful (number bytes received, 0 if nothing was waiting), -1 if fails.</returns>
+			int32_t ReceiveShared(const size_t shared, void* buffer, const uint32_t maxSize, sockaddr_in& sender, size_t& group, uint64_t& timestamp);
+
+			/// <summary>Creates a multicast socket bound to a port, ready to join groups</summary>
+			/// <param name="port"> -[in]- Port to bind to</param>
+			/// <param name="shared"> -[in]- True to report each datagram's destination group, for sockets joining several groups</param>
+			/// <returns>The socket if successful, INVALID_SOCKET if fails.</returns>
+			SOCKET OpenMulticastSocket(const int16_t port, const bool shared);
+
+			/// <summary>Applies the filter, buffer sizes and drop accounting configured for a kind of socket to a new one</summary>
+			/// <param name="sock"> -[in]- Socket to configure, before it is bound</param>
+			/// <param name="type"> -[in]- Kind of the socket</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t ApplySocketOptions(const SOCKET sock, const SendType type);
+
+			/// <summary>Sets the kernel busy-poll options on the unicast socket</summary>
+			/// <param name="sock"> -[in]- Socket to configure</param>
+			void ConfigureBusyPoll(const SOCKET sock);
+
+			/// <summary>Sets the buffer sizes configured for a kind of socket, if any</summary>
+			/// <param name="sock"> -[in]- Socket to size</param>
+			/// <param name="type"> -[in]- Kind of the socket</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t ApplyBufferSizes(const SOCKET sock, const SendType type);
+
+			/// <summary>Sets the configured receive timestamp options on a socket</summary>
+			/// <param name="sock"> -[in]- Socket to configure</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t ApplyTimestamps(const SOCKET sock);
+
+			/// <summary>Sets the configured departure time option on a socket</summary>
+			/// <param name="sock"> -[in]- Socket to configure</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t ApplyTransmitTime(const SOCKET sock);
+
+			/// <summary>Forgets the drop count of a socket about to close, a new socket may be handed the same number</summary>
+			/// <param name="sock"> -[in]- Socket being closed</param>
+			void ForgetDropCount(const SOCKET sock);
+
+#if defined __linux__
+			/// <summary>Reads a receive timestamp out of a control message and records the datagram's queue delay</summary>
+			/// <param name="message"> -[in]- Control message received with the datagram</param>
+			/// <param name="timestamp"> -[out]- Kernel arrival time, set if the message holds one</param>
+			/// <param name="hardwareTimestamp"> -[out]- NIC arrival time, set if the message holds one</param>
+			/// <returns>True if the message was a timestamp.</returns>
+			bool ReadTimestamp(const cmsghdr* message, uint64_t& timestamp, uint64_t& hardwareTimestamp);
+
+			/// <summary>Reads a kernel drop count out of a control message and records it against the socket</summary>
+			/// <param name="message"> -[in]- Control message received with the datagram</param>
+			/// <param name="sock"> -[in]- Socket the datagram arrived on</param>
+			/// <param name="drops"> -[out]- Socket's running drop count, set if the message holds one</param>
+			/// <returns>True if the message was a drop count.</returns>
+			bool ReadDropCount(const cmsghdr* message, const SOCKET sock, uint32_t& drops);
+#endif
+
+			/// <summary>Attaches the filter of a kind of socket, if one is set</summary>
+			/// <param name="sock"> -[in]- Socket to filter</param>
+			/// <param name="type"> -[in]- Kind of the socket</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t ApplyFilter(const SOCKET sock, const SendType type);
+
+			/// <summary>Collects every open socket of a kind</summary>
+			/// <param name="type"> -[in]- Kind of sockets</param>
+			/// <returns>The sockets, each listed once</returns>
+			std::vector<SOCKET> GetSockets(const SendType type);
+
+			/// <summary>Joins a group on a socket, for every source or only the listed ones</summary>
+			/// <param name="sock"> -[in]- Socket to join on</param>
+			/// <param name="group"> -[in]- Group address, network byte order</param>
+			/// <param name="sources"> -[in]- Sources to accept, empty accepts every source</param>
+			/// <returns>0 if successful, -1 if fails with the join's error left in errno (WSAGetLastError on windows).</returns>
+			int8_t JoinMulticastGroup(const SOCKET sock, const in_addr group, const std::vector<in_addr>& sources);
+
+			/// <summary>Finds or opens the shared socket for a port with room for another group</summary>
+			/// <param name="port"> -[in]- Port of the group</param>
+			/// <returns>Index in mSharedMulticastSockets if successful, -1 if fails.</returns>
+			int32_t AcquireSharedMulticastSocket(const int16_t port);
+
+			/// <summary>Check if a multicast socket is shared between groups</summary>
+			/// <param name="sock"> -[in]- Socket to check</param>
+			/// <returns>true if shared, false if it belongs to a single group</returns>
+			bool IsSharedMulticastSocket(const SOCKET sock);
+
+			/// <summary>Finds a joined group in mMulticastGroupIndex</summary>
+			/// <param name="group"> -[in]- Group address, network byte order</param>
+			/// <param name="port"> -[in]- Group port, network byte order</param>
+			/// <returns>Index of the group in mMulticastSockets, mMulticastSockets.size() if it is not joined</returns>
+			size_t LookupMulticastGroup(const in_addr group, const uint16_t port);
+
 			// Variables
 			std::string					mTitle;					// Title for this utility when using CPP_Logger
 			UdpClientError				mLastError;				// Last error for this utility
@@ -341,6 +1170,71 @@ namespace Essentials
 			SOCKET						mBroadcastSocket;		// socket FD for broadcasting
 			std::vector<std::tuple<SOCKET, sockaddr_in, Endpoint>>   mBroadcastListeners;	// Vector of tuples containing the socket and addr info for listening to broadcasts
 			std::vector<std::tuple<SOCKET, sockaddr_in, Endpoint>>   mMulticastSockets;		// Vector of tuples containing the socket and addr info for multicasts
+			SOCKET						mListenerPoll;			// epoll FD waiting on every listener, created with the first listener
+			std::unordered_map<SOCKET, size_t>	mListenerIndex;	// Listener index of each socket registered with mListenerPoll
+			ListenerCallback			mBroadcastCallback;		// Callback for broadcast datagrams received by PollListeners
+			ListenerCallback			mMulticastCallback;		// Callback for multicast datagrams received by PollListeners
+			std::vector<char>			mListenerBuffer;		// Receive buffer shared by the listener callbacks
+
+			/// <summary>A multicast socket joined to several groups of one port</summary>
+			struct SharedMulticastSocket
+			{
+				SOCKET										sock		= INVALID_SOCKET;	// Socket joined to the groups
+				int16_t										port		= 0;				// Port the socket is bound to
+				uint32_t									groups		= 0;				// Number of groups joined
+			};
+			std::vector<SharedMulticastSocket>	mSharedMulticastSockets;	// Sockets shared between multicast groups
+			std::unordered_map<uint32_t, std::vector<size_t>>	mMulticastGroupIndex;	// Group address to its entries in mMulticastSockets, one per port
+			bool						mSharedMulticast;		// True to join new groups on shared sockets
+			std::vector<SocketFilterInstruction>	mFilters[3];	// Filter program per SendType, empty when none is attached
+
+			/// <summary>Kernel buffer sizes requested for one kind of socket</summary>
+			struct SocketBufferSizes
+			{
+				int32_t										receive		= 0;	// Receive buffer size, 0 for the kernel default
+				int32_t										send		= 0;	// Send buffer size, 0 for the kernel default
+			};
+			SocketBufferSizes			mBufferSizes[3];		// Buffer sizes per SendType
+			std::atomic<bool>			mDropAccounting;		// True to enable SO_RXQ_OVFL on every socket, read by the receive threads
+			uint32_t					mKernelDrops;			// Last drop count reported on the unicast socket
+			std::unordered_map<SOCKET, uint32_t>	mSocketDrops;	// Last drop count reported on each socket
+			std::mutex					mDropLock;				// Guards mSocketDrops across receive threads
+			uint32_t					mBusyPollBudget;		// Microseconds the busy-poll receives spin before sleeping
+			std::atomic<bool>			mReceiveTimestamps;		// True to enable SO_TIMESTAMPNS on every socket, read by the receive threads
+			bool						mHardwareTimestamps;	// True to ask for NIC timestamps through SO_TIMESTAMPING
+			std::atomic<bool>			mTransmitTime;			// True to enable SO_TXTIME on the unicast and multicast sockets, read by pacing threads
+			LatencyHistogram			mQueueDelay;			// Socket queue delay of every timestamped datagram received
+			std::mutex					mQueueDelayLock;		// Guards mQueueDelay across receive threads
+			UDP_Uring*					mUring;					// io_uring engine, nullptr when the POSIX path is in use
+			bool						mSegmentOffload;		// False once the kernel has refused a UDP_SEGMENT send
+			bool						mReceiveCoalescing;		// True to enable UDP_GRO on the unicast socket
+			bool						mZeroCopy;				// True to enable SO_ZEROCOPY on the unicast and multicast sockets
+			ZeroCopyCallback			mZeroCopyCallback;		// Callback for completed zero-copy sends
+
+			/// <summary>Completion tracking for the zero-copy sends of one socket</summary>
+			struct ZeroCopyState
+			{
+				uint32_t									next		= 0;	// Sequence the kernel gives the next send
+				uint32_t									released	= 0;	// Every sequence before this one has completed
+				std::vector<std::pair<uint32_t, uint32_t>>	pending;			// Completed runs not yet joined to released
+			};
+			std::map<SOCKET, ZeroCopyState>	mZeroCopyStates;	// Zero-copy completion tracking per socket
+			UDP_PacketRing*				mReceiveRing;			// Ring filled by the receive thread, nullptr when it is not running
+			UDP_PacketRing*				mSendQueue;				// Unicast datagrams waiting for room in the socket buffer, nullptr when disabled
+			std::atomic<bool>			mSendQueueEnabled;		// True while mSendQueue exists, read by senders without the lock
+			bool						mSendQueueWatched;		// True while the unicast socket is watched for EPOLLOUT
+			uint32_t					mSendQueueHighWater;	// Depth at which mSendQueueCallback is invoked
+			bool						mSendQueueAboveHighWater;	// True from reaching the high-water mark until draining to half of it
+			uint64_t					mSendQueueDrops;		// Queued datagrams dropped because the socket refused them
+			SendQueueCallback			mSendQueueCallback;		// Callback for high-water crossings
+			std::mutex					mSendQueueLock;			// Guards mSendQueue between senders and the drain
+			std::thread					mReceiveThread;			// Background thread draining the sockets into mReceiveRing
+			std::atomic<bool>			mReceiveThreadRunning;	// Cleared to stop the receive thread
+			std::vector<SOCKET>			mShardSockets;			// SO_REUSEPORT sockets of the sharded receiver
+			std::vector<std::thread>	mShardThreads;			// Worker thread of each shard
+			std::atomic<bool>			mShardsRunning;			// Cleared to stop the shard workers
+			ShardCallback				mShardCallback;			// Callback for datagrams received by the shards
+			bool						mPeerPinned;			// True while the unicast socket is connected to mDestinationAddr
 		};
 	}
 }
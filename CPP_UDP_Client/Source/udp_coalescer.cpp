@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_coalescer.cpp
+//!
+//! @brief		Implementation of the udp coalescer
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_coalescer.h"			// UDP Coalescer Class
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		uint32_t CoalescedMessages::Count() const
+		{
+			uint32_t count = 0;
+
+			for (auto message = begin(); message != end(); ++message)
+			{
+				count++;
+			}
+
+			return count;
+		}
+
+		bool CoalescedMessages::IsValid() const
+		{
+			// Walk the prefixes by hand, the iterator hides where a malformed one stopped it.
+			uint32_t position = 0;
+
+			while (size - position >= UDP_COALESCER_PREFIX_SIZE)
+			{
+				uint32_t length = (static_cast<uint32_t>(static_cast<uint8_t>(data[position])) << 8) | static_cast<uint8_t>(data[position + 1]);
+
+				if (size - position - UDP_COALESCER_PREFIX_SIZE < length)
+				{
+					return false;
+				}
+
+				position += UDP_COALESCER_PREFIX_SIZE + length;
+			}
+
+			return size > 0 && position == size;
+		}
+
+		UDP_Coalescer::UDP_Coalescer(UDP_Client& client, const SendType type, const uint32_t maxDatagramSize, const uint32_t deadlineMicroseconds)
+			: mClient(client)
+		{
+			mType		= type;
+			mDeadline	= std::chrono::microseconds(deadlineMicroseconds);
+			mDatagram.resize(std::min(std::max(maxDatagramSize, UDP_COALESCER_PREFIX_SIZE + 1), UDP_MAX_GSO_PAYLOAD));
+			mUsed		= 0;
+			mPending	= 0;
+		}
+
+		UDP_Coalescer::~UDP_Coalescer()
+		{
+			Flush();
+		}
+
+		int32_t UDP_Coalescer::Send(const char* buffer, const uint32_t size)
+		{
+			if (size > mDatagram.size() - UDP_COALESCER_PREFIX_SIZE)
+			{
+				return -1;
+			}
+
+			int32_t sent = 0;
+
+			// Close the pending datagram if this message would overflow it or it has waited long enough.
+			if (mPending > 0 && (mUsed + UDP_COALESCER_PREFIX_SIZE + size > mDatagram.size() || GetTimeUntilDeadline() == 0))
+			{
+				sent = Flush();
+
+				if (sent < 0)
+				{
+					return -1;
+				}
+			}
+
+			if (mPending == 0)
+			{
+				mOldest = std::chrono::steady_clock::now();
+			}
+
+			mDatagram[mUsed] = static_cast<char>(size >> 8);
+			mDatagram[mUsed + 1] = static_cast<char>(size & 0xFF);
+			memcpy(mDatagram.data() + mUsed + UDP_COALESCER_PREFIX_SIZE, buffer, size);
+			mUsed += UDP_COALESCER_PREFIX_SIZE + size;
+			mPending++;
+
+			// Nothing more fits, or nothing is allowed to wait.
+			if (mDatagram.size() - mUsed <= UDP_COALESCER_PREFIX_SIZE || mDeadline.count() == 0)
+			{
+				int32_t flushed = Flush();
+
+				if (flushed < 0)
+				{
+					return -1;
+				}
+
+				sent += flushed;
+			}
+
+			return sent;
+		}
+
+		int32_t UDP_Coalescer::Flush()
+		{
+			if (mPending == 0)
+			{
+				return 0;
+			}
+
+			std::span<const char> datagram(mDatagram.data(), mUsed);
+			GatherBuffers pieces(&datagram, 1);
+
+			int32_t numSent = -1;
+			switch (mType)
+			{
+			case SendType::UNICAST:		numSent = mClient.SendUnicast(pieces);		break;
+			case SendType::BROADCAST:	numSent = mClient.SendBroadcast(pieces);	break;
+			case SendType::MULTICAST:	numSent = mClient.SendMulticast(pieces);	break;
+			default: break;
+			}
+
+			mUsed = 0;
+			mPending = 0;
+
+			return numSent < 0 ? -1 : 1;
+		}
+
+		int32_t UDP_Coalescer::FlushIfDue()
+		{
+			return GetTimeUntilDeadline() == 0 ? Flush() : 0;
+		}
+
+		int64_t UDP_Coalescer::GetTimeUntilDeadline() const
+		{
+			if (mPending == 0)
+			{
+				return -1;
+			}
+
+			auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mOldest);
+
+			return waited >= mDeadline ? 0 : (mDeadline - waited).count();
+		}
+
+		uint32_t UDP_Coalescer::GetPendingCount() const
+		{
+			return mPending;
+		}
+	}
+}
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_coalescer.h
+//!
+//! @brief		Packs small messages into shared datagrams and unpacks them on receipt.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "udp_client.h"					// UDP Client Class
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_COALESCER			// Define the cpp UDP coalescer class.
+#define     CPP_UDP_COALESCER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint32_t	UDP_COALESCER_PREFIX_SIZE		= 2;
+		constexpr static uint32_t	UDP_COALESCER_DEFAULT_MTU		= 1472;
+		constexpr static uint32_t	UDP_COALESCER_DEFAULT_DEADLINE	= 200;
+
+		/// <summary>A datagram packed by UDP_Coalescer, iterating it yields each message in place as a span.
+		/// Every message is preceded by its length as a big-endian 16 bit prefix.</summary>
+		struct CoalescedMessages
+		{
+			/// <summary>Walks the messages of a packed datagram without copying them, stopping at a malformed prefix</summary>
+			class Iterator
+			{
+			public:
+				Iterator(const char* position, const char* end)
+					: mPosition(Check(position, end)), mEnd(end) {}
+
+				std::span<const char> operator*() const
+				{
+					return std::span<const char>(mPosition + UDP_COALESCER_PREFIX_SIZE, Length(mPosition));
+				}
+
+				Iterator& operator++()
+				{
+					mPosition = Check(mPosition + UDP_COALESCER_PREFIX_SIZE + Length(mPosition), mEnd);
+					return *this;
+				}
+
+				bool operator!=(const Iterator& other) const { return mPosition != other.mPosition; }
+
+			private:
+				static uint32_t Length(const char* position)
+				{
+					return (static_cast<uint32_t>(static_cast<uint8_t>(position[0])) << 8) | static_cast<uint8_t>(position[1]);
+				}
+
+				static const char* Check(const char* position, const char* end)
+				{
+					// A prefix or message running past the datagram ends the walk.
+					if (end - position < static_cast<ptrdiff_t>(UDP_COALESCER_PREFIX_SIZE) ||
+						end - position - UDP_COALESCER_PREFIX_SIZE < static_cast<ptrdiff_t>(Length(position)))
+					{
+						return end;
+					}
+
+					return position;
+				}
+
+				const char*		mPosition;
+				const char*		mEnd;
+			};
+
+			const char*			data		= nullptr;	// Start of the received datagram
+			uint32_t			size		= 0;		// Number of bytes received
+
+			Iterator begin() const { return Iterator(data, data + size); }
+			Iterator end() const { return Iterator(data + size, data + size); }
+
+			/// <summary>Number of whole messages held by the datagram</summary>
+			uint32_t Count() const;
+
+			/// <summary>True if the messages exactly fill the datagram, false if it was truncated or not packed</summary>
+			bool IsValid() const;
+		};
+
+		/// <summary>Packs small messages bound for one kind of destination into as few datagrams as possible. A datagram
+		/// goes out once the next message would not fit, once its oldest message has waited for the deadline, or on Flush.
+		/// The deadline is only checked by Send and FlushIfDue, so a caller that stops sending must keep calling FlushIfDue,
+		/// for instance from its event loop with GetTimeUntilDeadline as the timeout. Meant for one sending thread.</summary>
+		class UDP_Coalescer
+		{
+		public:
+			/// <summary>Constructor taking the client and kind of send the packed datagrams go out on</summary>
+			/// <param name="client"> -[in]- Client to send through, must outlive the coalescer</param>
+			/// <param name="type"> -[in]- Unicast to the unicast destination, broadcast, or multicast to every joined group</param>
+			/// <param name="maxDatagramSize"> -[in]- Largest datagram to build, the path MTU less the IP and UDP headers</param>
+			/// <param name="deadlineMicroseconds"> -[in]- Longest a message may wait for company, 0 sends every message at once</param>
+			UDP_Coalescer(UDP_Client& client, const SendType type, const uint32_t maxDatagramSize = UDP_COALESCER_DEFAULT_MTU,
+				const uint32_t deadlineMicroseconds = UDP_COALESCER_DEFAULT_DEADLINE);
+
+			/// <summary>Default Deconstructor, sends whatever is still pending</summary>
+			~UDP_Coalescer();
+
+			UDP_Coalescer(const UDP_Coalescer&) = delete;
+			UDP_Coalescer& operator=(const UDP_Coalescer&) = delete;
+
+			/// <summary>Adds a message to the pending datagram, sending it first if the message does not fit or the deadline passed</summary>
+			/// <param name="buffer"> -[in]- Message to be sent</param>
+			/// <param name="size"> -[in]- Size of the message, at most the datagram size less the prefix</param>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if the message is too large or a send failed.
+			/// Call UDP_Client::GetLastError to find out more about a failed send.</returns>
+			int32_t Send(const char* buffer, const uint32_t size);
+
+			/// <summary>Sends the pending datagram now</summary>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if fails. Pending messages are dropped on failure.</returns>
+			int32_t Flush();
+
+			/// <summary>Sends the pending datagram if its oldest message has reached the deadline</summary>
+			/// <returns>0+ if successful (number of datagrams sent), -1 if fails.</returns>
+			int32_t FlushIfDue();
+
+			/// <summary>Get the time left before the pending datagram is due</summary>
+			/// <returns>Microseconds until the deadline, 0 if it is due, -1 if nothing is pending</returns>
+			int64_t GetTimeUntilDeadline() const;
+
+			/// <summary>Get the number of messages waiting in the pending datagram</summary>
+			/// <returns>Number of pending messages</returns>
+			uint32_t GetPendingCount() const;
+
+		protected:
+		private:
+			UDP_Client&					mClient;				// Client carrying the sends
+			SendType					mType;					// Kind of send the datagrams go out on
+			std::chrono::microseconds	mDeadline;				// Longest a message may wait
+			std::vector<char>			mDatagram;				// Pending datagram, sized to the largest datagram
+			uint32_t					mUsed;					// Bytes of the pending datagram filled
+			uint32_t					mPending;				// Messages in the pending datagram
+			std::chrono::steady_clock::time_point	mOldest;	// Time the first pending message was added
+		};
+	}
+}
+
+#endif		// CPP_UDP_COALESCER
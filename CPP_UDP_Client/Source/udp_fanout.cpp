@@ -0,0 +1,343 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_fanout.cpp
+//!
+//! @brief		Implementation of the udp fan out
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_fanout.h"				// UDP Fan Out Class
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		/// <summary>True if two addresses name the same subscriber</summary>
+		static bool SameSubscriber(const sockaddr_in& a, const sockaddr_in& b)
+		{
+			return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+		}
+
+		/// <summary>Packs a subscriber's address and port into one key</summary>
+		static uint64_t SubscriberKey(const sockaddr_in& address)
+		{
+			return (static_cast<uint64_t>(address.sin_addr.s_addr) << 16) | address.sin_port;
+		}
+
+		UDP_FanOut::UDP_FanOut(UDP_Client& client, const uint32_t workerCount, const uint32_t sendTimeoutMSecs) : mClient(client)
+		{
+			mTable			= std::make_shared<const SubscriberTable>();
+			mSendTimeout	= std::chrono::milliseconds(sendTimeoutMSecs);
+			mShares.resize(static_cast<size_t>(workerCount) + 1);
+			mSendBuffer		= nullptr;
+			mSendSize		= 0;
+			mGeneration		= 0;
+			mPending		= 0;
+			mStopping		= false;
+
+			for (uint32_t i = 0; i < workerCount; i++)
+			{
+				mWorkers.emplace_back(&UDP_FanOut::WorkerLoop, this, i + 1);
+			}
+		}
+
+		UDP_FanOut::~UDP_FanOut()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mWorkLock);
+				mStopping = true;
+			}
+
+			mWorkReady.notify_all();
+
+			for (auto& worker : mWorkers)
+			{
+				worker.join();
+			}
+		}
+
+		int8_t UDP_FanOut::AddSubscriber(const std::string& ipAddress, const int16_t port)
+		{
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+
+			if (port < 0 || inet_pton(AF_INET, ipAddress.c_str(), &address.sin_addr) != 1)
+			{
+				return -1;
+			}
+
+			AddSubscriber(address);
+			return 0;
+		}
+
+		void UDP_FanOut::AddSubscriber(const sockaddr_in& address)
+		{
+			std::lock_guard<std::mutex> lock(mWriterLock);
+			std::shared_ptr<const SubscriberTable> current = mTable.load();
+
+			for (const auto& subscriber : *current)
+			{
+				if (SameSubscriber(subscriber, address))
+				{
+					return;
+				}
+			}
+
+			// Senders keep using the old table until they finish, the new one is published whole.
+			auto updated = std::make_shared<SubscriberTable>(*current);
+			updated->push_back(address);
+			mTable.store(std::move(updated));
+		}
+
+		void UDP_FanOut::AddSubscribers(std::span<const sockaddr_in> addresses)
+		{
+			std::lock_guard<std::mutex> lock(mWriterLock);
+			std::shared_ptr<const SubscriberTable> current = mTable.load();
+
+			std::unordered_set<uint64_t> subscribed;
+			subscribed.reserve(current->size() + addresses.size());
+
+			for (const auto& subscriber : *current)
+			{
+				subscribed.insert(SubscriberKey(subscriber));
+			}
+
+			auto updated = std::make_shared<SubscriberTable>(*current);
+			updated->reserve(current->size() + addresses.size());
+
+			for (const auto& address : addresses)
+			{
+				if (subscribed.insert(SubscriberKey(address)).second)
+				{
+					updated->push_back(address);
+				}
+			}
+
+			if (updated->size() != current->size())
+			{
+				mTable.store(std::move(updated));
+			}
+		}
+
+		void UDP_FanOut::SetSubscribers(std::span<const sockaddr_in> addresses)
+		{
+			std::unordered_set<uint64_t> subscribed;
+			subscribed.reserve(addresses.size());
+
+			auto updated = std::make_shared<SubscriberTable>();
+			updated->reserve(addresses.size());
+
+			for (const auto& address : addresses)
+			{
+				if (subscribed.insert(SubscriberKey(address)).second)
+				{
+					updated->push_back(address);
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(mWriterLock);
+			mTable.store(std::move(updated));
+		}
+
+		int8_t UDP_FanOut::RemoveSubscriber(const sockaddr_in& address)
+		{
+			std::lock_guard<std::mutex> lock(mWriterLock);
+			std::shared_ptr<const SubscriberTable> current = mTable.load();
+
+			auto updated = std::make_shared<SubscriberTable>();
+			updated->reserve(current->size());
+
+			for (const auto& subscriber : *current)
+			{
+				if (!SameSubscriber(subscriber, address))
+				{
+					updated->push_back(subscriber);
+				}
+			}
+
+			if (updated->size() == current->size())
+			{
+				return -1;
+			}
+
+			mTable.store(std::move(updated));
+			return 0;
+		}
+
+		void UDP_FanOut::ClearSubscribers()
+		{
+			std::lock_guard<std::mutex> lock(mWriterLock);
+			mTable.store(std::make_shared<const SubscriberTable>());
+		}
+
+		size_t UDP_FanOut::GetSubscriberCount() const
+		{
+			return mTable.load()->size();
+		}
+
+		int32_t UDP_FanOut::Send(const char* buffer, const uint32_t size)
+		{
+			std::shared_ptr<const SubscriberTable> table = mTable.load();
+			size_t shareCount = mShares.size();
+			size_t shareSize = (table->size() + shareCount - 1) / shareCount;
+
+			// Split the table into one contiguous range per thread.
+			for (size_t i = 0; i < shareCount; i++)
+			{
+				mShares[i].first = std::min(table->size(), i * shareSize);
+				mShares[i].last = std::min(table->size(), mShares[i].first + shareSize);
+				mShares[i].sent = 0;
+			}
+
+			mSendTable = table;
+			mSendBuffer = buffer;
+			mSendSize = size;
+
+			if (!mWorkers.empty())
+			{
+				{
+					std::lock_guard<std::mutex> lock(mWorkLock);
+					mPending = static_cast<uint32_t>(mWorkers.size());
+					mGeneration++;
+				}
+
+				mWorkReady.notify_all();
+			}
+
+			SendRange(mShares[0]);
+
+			if (!mWorkers.empty())
+			{
+				std::unique_lock<std::mutex> lock(mWorkLock);
+				mWorkDone.wait(lock, [this] { return mPending == 0; });
+			}
+
+			mSendTable.reset();
+
+			int32_t totalSent = 0;
+			for (const auto& share : mShares)
+			{
+				totalSent += share.sent;
+			}
+
+			// Nothing reached anyone although there was someone to send to.
+			if (totalSent == 0 && !table->empty())
+			{
+				return -1;
+			}
+
+			return totalSent;
+		}
+
+		void UDP_FanOut::SendRange(SendShare& share)
+		{
+			const SubscriberTable& table = *mSendTable;
+			size_t count = share.last - share.first;
+
+			if (share.records.size() < count)
+			{
+				share.records.resize(count);
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				UdpSendRecord& record = share.records[i];
+				record.buffer = mSendBuffer;
+				record.size = mSendSize;
+				record.destination = &table[share.first + i];
+			}
+
+			// A batch stops at the first subscriber it cannot send to. Sending again from there reports why: a full
+			// send buffer is waited out and the subscriber retried, an error of its own skips it, a dead socket ends the share.
+			// The error comes back to this thread alone, the workers never touch the client's error state.
+			size_t offset = 0;
+			auto deadline = std::chrono::steady_clock::time_point::max();
+
+			while (offset < count)
+			{
+				int32_t errorCode = 0;
+				int32_t sent = mClient.SendUnicastBatch(std::span<UdpSendRecord>(share.records.data() + offset, count - offset), errorCode);
+
+				if (sent > 0)
+				{
+					share.sent += sent;
+					offset += static_cast<size_t>(sent);
+					deadline = std::chrono::steady_clock::time_point::max();
+					continue;
+				}
+
+#ifdef WIN32
+				bool full = errorCode == WSAEWOULDBLOCK || errorCode == WSAENOBUFS;
+				bool broken = errorCode == 0 || errorCode == WSAENOTSOCK;
+#else
+				bool full = errorCode == EWOULDBLOCK || errorCode == ENOBUFS;
+				bool broken = errorCode == 0 || errorCode == EBADF || errorCode == ENOTSOCK;
+#endif
+				if (full)
+				{
+					auto now = std::chrono::steady_clock::now();
+
+					if (deadline == std::chrono::steady_clock::time_point::max())
+					{
+						deadline = now + mSendTimeout;
+					}
+					else if (now >= deadline)
+					{
+						return;
+					}
+
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+					continue;
+				}
+
+				if (broken)
+				{
+					return;
+				}
+
+				offset++;
+			}
+		}
+
+		void UDP_FanOut::WorkerLoop(const uint32_t worker)
+		{
+			uint64_t seen = 0;
+
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mWorkLock);
+					mWorkReady.wait(lock, [this, seen] { return mStopping || mGeneration != seen; });
+
+					if (mStopping)
+					{
+						return;
+					}
+
+					seen = mGeneration;
+				}
+
+				SendRange(mShares[worker]);
+
+				{
+					std::lock_guard<std::mutex> lock(mWorkLock);
+					mPending--;
+				}
+
+				mWorkDone.notify_one();
+			}
+		}
+	}
+}
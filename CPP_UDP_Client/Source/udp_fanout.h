@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_fanout.h
+//!
+//! @brief		Sends one payload to a large table of unicast subscribers.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "udp_client.h"					// UDP Client Class
+#include <memory>						// Subscriber table snapshots
+#include <mutex>						// Table writers and worker hand off
+#include <condition_variable>			// Worker wake up
+#include <unordered_set>				// Bulk subscriber de-duplication
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_FANOUT				// Define the cpp UDP fan out class.
+#define     CPP_UDP_FANOUT
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint32_t	UDP_FANOUT_DEFAULT_TIMEOUT		= 100;
+
+		/// <summary>Fans one payload out to every subscriber through a client's unicast socket using batched sends.
+		/// Subscribers live in a flat copy-on-write table, so adding or removing them never blocks a send in progress. 
+		/// A full send buffer is waited out and the same subscriber retried, a subscriber the kernel refuses is skipped.</summary>
+		class UDP_FanOut
+		{
+		public:
+			/// <summary>Constructor taking the client whose open unicast socket carries the sends</summary>
+			/// <param name="client"> -[in]- Client to send through, must outlive the fan out</param>
+			/// <param name="workerCount"> -[in]- Extra threads splitting each send with the caller, 0 sends on the caller only</param>
+			/// <param name="sendTimeoutMSecs"> -[in]- Longest a share may wait for room in the send buffer without progress</param>
+			UDP_FanOut(UDP_Client& client, const uint32_t workerCount = 0, const uint32_t sendTimeoutMSecs = UDP_FANOUT_DEFAULT_TIMEOUT);
+
+			/// <summary>Default Deconstructor, stops the workers</summary>
+			~UDP_FanOut();
+
+			UDP_FanOut(const UDP_FanOut&) = delete;
+			UDP_FanOut& operator=(const UDP_FanOut&) = delete;
+
+			/// <summary>Adds a subscriber, ignored if it is already subscribed</summary>
+			/// <param name="ipAddress"> -[in]- IPv4 address of the subscriber</param>
+			/// <param name="port"> -[in]- Port of the subscriber</param>
+			/// <returns>0 if successful, -1 if the address or port is invalid.</returns>
+			int8_t AddSubscriber(const std::string& ipAddress, const int16_t port);
+
+			/// <summary>Adds a pre-resolved subscriber, ignored if it is already subscribed</summary>
+			/// <param name="address"> -[in]- Address and port of the subscriber, network byte order</param>
+			void AddSubscriber(const sockaddr_in& address);
+
+			/// <summary>Adds many pre-resolved subscribers with a single table copy, those already subscribed are ignored</summary>
+			/// <param name="addresses"> -[in]- Addresses and ports of the subscribers, network byte order</param>
+			void AddSubscribers(std::span<const sockaddr_in> addresses);
+
+			/// <summary>Replaces every subscriber with a new set in a single table copy, duplicates are dropped</summary>
+			/// <param name="addresses"> -[in]- Addresses and ports of the subscribers, network byte order</param>
+			void SetSubscribers(std::span<const sockaddr_in> addresses);
+
+			/// <summary>Removes a subscriber</summary>
+			/// <param name="address"> -[in]- Address and port of the subscriber, network byte order</param>
+			/// <returns>0 if removed, -1 if it was not subscribed.</returns>
+			int8_t RemoveSubscriber(const sockaddr_in& address);
+
+			/// <summary>Removes every subscriber</summary>
+			void ClearSubscribers();
+
+			/// <summary>Get the number of subscribers</summary>
+			/// <returns>Number of subscribers</returns>
+			size_t GetSubscriberCount() const;
+
+			/// <summary>Sends a payload to every subscriber of the current table</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <returns>0+ if successful (number of subscribers sent to), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t Send(const char* buffer, const uint32_t size);
+
+		protected:
+		private:
+			using SubscriberTable = std::vector<sockaddr_in>;
+
+			/// <summary>One share of a send, a range of the table sent with reusable records</summary>
+			struct SendShare
+			{
+				size_t						first = 0;			// First subscriber of the share
+				size_t						last = 0;			// One past the last subscriber of the share
+				int32_t						sent = 0;			// -[out]- Number of subscribers sent to
+				std::vector<UdpSendRecord>	records;			// Records reused across sends
+			};
+
+			/// <summary>Sends one share of the current send</summary>
+			/// <param name="share"> -[in/out]- Share to be sent</param>
+			void SendRange(SendShare& share);
+
+			/// <summary>Worker thread body, sends its share of each send</summary>
+			/// <param name="worker"> -[in]- Index of the worker's share</param>
+			void WorkerLoop(const uint32_t worker);
+
+			UDP_Client&							mClient;			// Client carrying the sends
+			std::chrono::milliseconds			mSendTimeout;		// Longest a share waits for the send buffer
+			std::atomic<std::shared_ptr<const SubscriberTable>>	mTable;	// Current subscriber table
+			std::mutex							mWriterLock;		// Serializes table updates
+			std::vector<SendShare>				mShares;			// Caller's share followed by each worker's
+			std::vector<std::thread>			mWorkers;			// Worker threads
+			std::mutex							mWorkLock;			// Guards the hand off below
+			std::condition_variable				mWorkReady;			// Signals workers a send started or stop was requested
+			std::condition_variable				mWorkDone;			// Signals the caller a worker finished
+			std::shared_ptr<const SubscriberTable>	mSendTable;		// Table of the send in progress
+			const char*							mSendBuffer;		// Payload of the send in progress
+			uint32_t							mSendSize;			// Payload size of the send in progress
+			uint64_t							mGeneration;		// Incremented for every send handed to the workers
+			uint32_t							mPending;			// Workers still sending their share
+			bool								mStopping;			// Set to stop the workers
+		};
+	}
+}
+
+#endif		// CPP_UDP_FANOUT
@@ -0,0 +1,355 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_fragmenter.cpp
+//!
+//! @brief		Implementation of the udp fragmenter and reassembler
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_fragmenter.h"			// UDP Fragmenter Classes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		/// <summary>Writes a 16 bit value big-endian</summary>
+		static void Put16(char* position, const uint32_t value)
+		{
+			position[0] = static_cast<char>(value >> 8);
+			position[1] = static_cast<char>(value);
+		}
+
+		/// <summary>Writes a 32 bit value big-endian</summary>
+		static void Put32(char* position, const uint32_t value)
+		{
+			Put16(position, value >> 16);
+			Put16(position + 2, value & 0xFFFF);
+		}
+
+		/// <summary>Reads a big-endian 16 bit value</summary>
+		static uint32_t Get16(const char* position)
+		{
+			return (static_cast<uint32_t>(static_cast<uint8_t>(position[0])) << 8) | static_cast<uint8_t>(position[1]);
+		}
+
+		/// <summary>Reads a big-endian 32 bit value</summary>
+		static uint32_t Get32(const char* position)
+		{
+			return (Get16(position) << 16) | Get16(position + 2);
+		}
+
+		UDP_Fragmenter::UDP_Fragmenter(UDP_Client& client, const SendType type, const uint32_t maxDatagramSize, const uint32_t sendTimeoutMSecs)
+			: mClient(client)
+		{
+			mType			= type;
+			mStride			= std::min(std::max(maxDatagramSize, UDP_FRAGMENT_HEADER_SIZE + 1), UDP_MAX_GSO_PAYLOAD) - UDP_FRAGMENT_HEADER_SIZE;
+			mSendTimeout	= std::chrono::milliseconds(sendTimeoutMSecs);
+			mNextId			= std::random_device()();
+		}
+
+		int32_t UDP_Fragmenter::Send(const char* buffer, const uint32_t size)
+		{
+			uint64_t count = size == 0 ? 1 : (static_cast<uint64_t>(size) + mStride - 1) / mStride;
+
+			if (count > UDP_FRAGMENT_MAX_COUNT)
+			{
+				return -1;
+			}
+
+			uint32_t id = mNextId++;
+			char header[UDP_FRAGMENT_HEADER_SIZE];
+			Put16(header, UDP_FRAGMENT_MAGIC);
+			Put16(header + 2, mStride);
+			Put32(header + 4, id);
+			Put32(header + 8, size);
+			Put16(header + 14, static_cast<uint32_t>(count));
+
+			for (uint32_t index = 0; index < count; index++)
+			{
+				Put16(header + 12, index);
+
+				uint32_t offset = index * mStride;
+				std::span<const char> pieces[2] = { std::span<const char>(header, UDP_FRAGMENT_HEADER_SIZE),
+					std::span<const char>(buffer + offset, std::min(mStride, size - offset)) };
+
+				if (SendFragment(GatherBuffers(pieces)) < 0)
+				{
+					return -1;
+				}
+			}
+
+			return static_cast<int32_t>(count);
+		}
+
+		int32_t UDP_Fragmenter::SendFragment(GatherBuffers pieces)
+		{
+			auto deadline = std::chrono::steady_clock::now() + mSendTimeout;
+
+			while (true)
+			{
+				int32_t numSent = -1;
+				switch (mType)
+				{
+				case SendType::UNICAST:		numSent = mClient.SendUnicast(pieces);		break;
+				case SendType::BROADCAST:	numSent = mClient.SendBroadcast(pieces);	break;
+				case SendType::MULTICAST:	numSent = mClient.SendMulticast(pieces);	break;
+				default: return -1;
+				}
+
+				if (numSent >= 0)
+				{
+					return numSent;
+				}
+
+				// A burst of fragments outruns the interface, give the send buffer a moment to drain.
+#ifdef WIN32
+				bool full = WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+				bool full = errno == EWOULDBLOCK || errno == ENOBUFS;
+#endif
+				if (!full || std::chrono::steady_clock::now() >= deadline)
+				{
+					return -1;
+				}
+
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+
+		UDP_Reassembler::UDP_Reassembler(const uint32_t slotCount, const uint32_t maxMessageSize, const uint32_t timeoutMSecs)
+		{
+			mMaxMessageSize	= maxMessageSize;
+			mTimeout		= std::chrono::milliseconds(timeoutMSecs);
+			mLastSlot		= 0;
+			mCompletedSlot	= UINT32_MAX;
+			mPending		= 0;
+			mRecent			= {};
+			mNextRecent		= 0;
+			mStats			= {};
+
+			// The smallest stride a sender can use bounds the number of fragments, and so the bitmap.
+			uint32_t maxFragments = std::min(std::max(maxMessageSize, 1u), UDP_FRAGMENT_MAX_COUNT);
+
+			mSlots.resize(std::max(slotCount, 1u));
+			for (Slot& slot : mSlots)
+			{
+				slot.data.resize(maxMessageSize);
+				slot.bitmap.resize((maxFragments + 63) / 64);
+			}
+		}
+
+		int32_t UDP_Reassembler::Receive(const char* datagram, const uint32_t size, const sockaddr_in& source, ReassembledMessage& message)
+		{
+			// The message handed out last time is no longer in use.
+			if (mCompletedSlot != UINT32_MAX)
+			{
+				mSlots[mCompletedSlot].busy = false;
+				mCompletedSlot = UINT32_MAX;
+			}
+
+			if (size < UDP_FRAGMENT_HEADER_SIZE || Get16(datagram) != UDP_FRAGMENT_MAGIC)
+			{
+				mStats.rejected++;
+				return -1;
+			}
+
+			uint32_t stride		= Get16(datagram + 2);
+			uint32_t id			= Get32(datagram + 4);
+			uint32_t total		= Get32(datagram + 8);
+			uint32_t index		= Get16(datagram + 12);
+			uint32_t count		= Get16(datagram + 14);
+			uint32_t payload	= size - UDP_FRAGMENT_HEADER_SIZE;
+			uint64_t offset		= static_cast<uint64_t>(index) * stride;
+
+			// Every fragment but the last fills its stride, the last ends the message.
+			bool consistent = stride > 0 && count > 0 && index < count && total <= mMaxMessageSize &&
+				static_cast<uint64_t>(count - 1) * stride < std::max(total, 1u) && static_cast<uint64_t>(count) * stride >= total &&
+				offset + payload == (index + 1 == count ? total : offset + stride);
+
+			if (!consistent)
+			{
+				mStats.rejected++;
+				return -1;
+			}
+
+			// A fragment arriving again after its message was handed out would otherwise start the message over.
+			if (RecentlyCompleted(source, id))
+			{
+				mStats.duplicates++;
+				return 0;
+			}
+
+			auto now = std::chrono::steady_clock::now();
+			bool created = false;
+			uint32_t number = FindSlot(source, id, now, created);
+			Slot& slot = mSlots[number];
+
+			if (created)
+			{
+				slot.size		= total;
+				slot.stride		= stride;
+				slot.count		= count;
+				slot.received	= 0;
+				slot.started	= now;
+				std::fill(slot.bitmap.begin(), slot.bitmap.begin() + (count + 63) / 64, 0);
+			}
+			else if (slot.size != total || slot.stride != stride || slot.count != count)
+			{
+				mStats.rejected++;
+				return -1;
+			}
+
+			uint64_t bit = 1ULL << (index % 64);
+			if (slot.bitmap[index / 64] & bit)
+			{
+				mStats.duplicates++;
+				return 0;
+			}
+
+			slot.bitmap[index / 64] |= bit;
+			memcpy(slot.data.data() + offset, datagram + UDP_FRAGMENT_HEADER_SIZE, payload);
+			slot.received++;
+
+			if (slot.received < slot.count)
+			{
+				return 0;
+			}
+
+			mStats.completed++;
+			mCompletedSlot = number;
+			mPending--;
+
+			mRecent[mNextRecent] = { true, slot.source, slot.id };
+			mNextRecent = (mNextRecent + 1) % UDP_REASSEMBLER_RECENT_COUNT;
+
+			message.data	= slot.data.data();
+			message.size	= slot.size;
+			message.id		= slot.id;
+			message.source	= slot.source;
+
+			return 1;
+		}
+
+		uint32_t UDP_Reassembler::ExpireStale()
+		{
+			auto now = std::chrono::steady_clock::now();
+			uint32_t expired = 0;
+
+			for (uint32_t number = 0; number < mSlots.size(); number++)
+			{
+				if (mSlots[number].busy && number != mCompletedSlot && now - mSlots[number].started > mTimeout)
+				{
+					mSlots[number].busy = false;
+					mPending--;
+					expired++;
+				}
+			}
+
+			mStats.timedOut += expired;
+			return expired;
+		}
+
+		uint32_t UDP_Reassembler::GetPendingCount() const
+		{
+			return mPending;
+		}
+
+		ReassemblyStats UDP_Reassembler::GetStats() const
+		{
+			return mStats;
+		}
+
+		bool UDP_Reassembler::RecentlyCompleted(const sockaddr_in& source, const uint32_t id) const
+		{
+			for (const CompletedMessage& entry : mRecent)
+			{
+				if (entry.used && entry.id == id && entry.source.sin_port == source.sin_port &&
+					entry.source.sin_addr.s_addr == source.sin_addr.s_addr)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		uint32_t UDP_Reassembler::FindSlot(const sockaddr_in& source, const uint32_t id, const std::chrono::steady_clock::time_point now, bool& created)
+		{
+			auto matches = [&](const Slot& slot)
+			{
+				return slot.busy && slot.id == id && slot.source.sin_port == source.sin_port &&
+					slot.source.sin_addr.s_addr == source.sin_addr.s_addr;
+			};
+
+			created = false;
+
+			if (matches(mSlots[mLastSlot]))
+			{
+				return mLastSlot;
+			}
+
+			// Prefer the message's own slot, then a free one, then the oldest, which is the first to time out.
+			uint32_t free = UINT32_MAX;
+			uint32_t oldest = UINT32_MAX;
+
+			for (uint32_t number = 0; number < mSlots.size(); number++)
+			{
+				const Slot& slot = mSlots[number];
+
+				if (matches(slot))
+				{
+					mLastSlot = number;
+					return number;
+				}
+
+				if (!slot.busy)
+				{
+					free = free == UINT32_MAX ? number : free;
+				}
+				else if (oldest == UINT32_MAX || slot.started < mSlots[oldest].started)
+				{
+					oldest = number;
+				}
+			}
+
+			uint32_t number = free;
+			if (number == UINT32_MAX)
+			{
+				number = oldest;
+
+				if (now - mSlots[number].started > mTimeout)
+				{
+					mStats.timedOut++;
+				}
+				else
+				{
+					mStats.evicted++;
+				}
+			}
+			else
+			{
+				mPending++;
+			}
+
+			Slot& slot = mSlots[number];
+			slot.busy	= true;
+			slot.source	= source;
+			slot.id		= id;
+
+			created = true;
+			mLastSlot = number;
+			return number;
+		}
+	}
+}
@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_fragmenter.h
+//!
+//! @brief		Splits large messages into datagrams and puts them back together.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "udp_client.h"					// UDP Client Class
+#include <array>						// Recently completed messages
+#include <random>						// Random first message id
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_FRAGMENTER			// Define the cpp UDP fragmenter classes.
+#define     CPP_UDP_FRAGMENTER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint32_t	UDP_FRAGMENT_HEADER_SIZE		= 16;
+		constexpr static uint16_t	UDP_FRAGMENT_MAGIC				= 0x5546;
+		constexpr static uint32_t	UDP_FRAGMENT_MAX_COUNT			= 65535;
+		constexpr static uint32_t	UDP_FRAGMENTER_DEFAULT_MTU		= 1472;
+		constexpr static uint32_t	UDP_FRAGMENTER_DEFAULT_TIMEOUT	= 100;
+		constexpr static uint32_t	UDP_REASSEMBLER_RECENT_COUNT	= 32;
+
+		/// <summary>Splits messages into numbered fragments, each small enough to avoid IP fragmentation. Every fragment
+		/// starts with a 16 byte header in network byte order: magic, payload stride, message id, message size, fragment
+		/// index and fragment count. Ids start at a random value, so a restarted sender is not mistaken for the copies of 
+		/// its previous run's messages. The fragments of a message leave back to back, so the receiving socket buffer must
+		/// hold a whole message (UDP_Client::SetSocketBufferSizes). A full send buffer is waited out rather than failing the
+		/// message; a fragment bound for several multicast groups may reach the earlier ones twice, the reassembler drops the copy.</summary>
+		class UDP_Fragmenter
+		{
+		public:
+			/// <summary>Constructor taking the client and kind of send the fragments go out on</summary>
+			/// <param name="client"> -[in]- Client to send through, must outlive the fragmenter</param>
+			/// <param name="type"> -[in]- Unicast to the unicast destination, broadcast, or multicast to every joined group</param>
+			/// <param name="maxDatagramSize"> -[in]- Largest fragment to send, the path MTU less the IP and UDP headers</param>
+			/// <param name="sendTimeoutMSecs"> -[in]- Longest a fragment may wait for room in the send buffer</param>
+			UDP_Fragmenter(UDP_Client& client, const SendType type, const uint32_t maxDatagramSize = UDP_FRAGMENTER_DEFAULT_MTU,
+				const uint32_t sendTimeoutMSecs = UDP_FRAGMENTER_DEFAULT_TIMEOUT);
+
+			UDP_Fragmenter(const UDP_Fragmenter&) = delete;
+			UDP_Fragmenter& operator=(const UDP_Fragmenter&) = delete;
+
+			/// <summary>Sends a message as fragments, the payload of each is handed to the kernel without being copied</summary>
+			/// <param name="buffer"> -[in]- Message to be sent</param>
+			/// <param name="size"> -[in]- Size of the message</param>
+			/// <returns>0+ if successful (number of fragments sent), -1 if the message needs too many fragments, the send buffer
+			/// stayed full past the timeout or a send failed. Call UDP_Client::GetLastError to find out more about a failed send.</returns>
+			int32_t Send(const char* buffer, const uint32_t size);
+
+		protected:
+		private:
+			/// <summary>Sends one fragment, waiting for room in the send buffer</summary>
+			/// <param name="pieces"> -[in]- Header and payload of the fragment</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails.</returns>
+			int32_t SendFragment(GatherBuffers pieces);
+
+			UDP_Client&					mClient;				// Client carrying the sends
+			SendType					mType;					// Kind of send the fragments go out on
+			uint32_t					mStride;				// Payload bytes carried by every fragment but the last
+			std::chrono::milliseconds	mSendTimeout;			// Longest a fragment may wait for the send buffer
+			uint32_t					mNextId;				// Id of the next message, random at construction
+		};
+
+		/// <summary>A message put back together by UDP_Reassembler</summary>
+		struct ReassembledMessage
+		{
+			const char*			data		= nullptr;	// Message data, valid until the next UDP_Reassembler::Receive
+			uint32_t			size		= 0;		// Size of the message
+			uint32_t			id			= 0;		// Sender's id of the message
+			sockaddr_in			source		= {};		// Address and port of the sender, network byte order
+		};
+
+		/// <summary>Counters kept by a reassembler</summary>
+		struct ReassemblyStats
+		{
+			uint64_t			completed	= 0;		// Messages put back together
+			uint64_t			timedOut	= 0;		// Messages abandoned after the timeout
+			uint64_t			evicted		= 0;		// Messages abandoned to make room for a newer one
+			uint64_t			duplicates	= 0;		// Fragments received more than once
+			uint64_t			rejected	= 0;		// Datagrams that were not fragments or did not fit a slot
+		};
+
+		/// <summary>Puts fragmented messages back together in a fixed table of slots allocated up front, so the memory used
+		/// never grows past slotCount times maxMessageSize. A slot is released when its message completes, when it has waited
+		/// longer than the timeout, or when every slot is busy and it holds the oldest message. Each fragment is copied once and
+		/// marked in a bitmap, so a message costs O(fragments). The last UDP_REASSEMBLER_RECENT_COUNT completed messages are
+		/// remembered, a late copy of one of their fragments counts as a duplicate instead of starting the message over. 
+		/// Meant for one receiving thread.</summary>
+		class UDP_Reassembler
+		{
+		public:
+			/// <summary>Constructor to allocate every slot up front</summary>
+			/// <param name="slotCount"> -[in]- Number of messages that can be in flight at once</param>
+			/// <param name="maxMessageSize"> -[in]- Largest message accepted</param>
+			/// <param name="timeoutMSecs"> -[in]- Longest a message may take to complete</param>
+			UDP_Reassembler(const uint32_t slotCount, const uint32_t maxMessageSize, const uint32_t timeoutMSecs);
+
+			UDP_Reassembler(const UDP_Reassembler&) = delete;
+			UDP_Reassembler& operator=(const UDP_Reassembler&) = delete;
+
+			/// <summary>Takes in one received datagram</summary>
+			/// <param name="datagram"> -[in]- Received data</param>
+			/// <param name="size"> -[in]- Number of bytes received</param>
+			/// <param name="source"> -[in]- Sender of the datagram</param>
+			/// <param name="message"> -[out]- Completed message, set when 1 is returned</param>
+			/// <returns>1 if a message completed, 0 if the fragment was kept or was a duplicate, -1 if the datagram was rejected.</returns>
+			int32_t Receive(const char* datagram, const uint32_t size, const sockaddr_in& source, ReassembledMessage& message);
+
+			/// <summary>Releases every slot that has waited longer than the timeout</summary>
+			/// <returns>Number of messages abandoned</returns>
+			uint32_t ExpireStale();
+
+			/// <summary>Get the number of messages being put back together</summary>
+			/// <returns>Number of incomplete messages held</returns>
+			uint32_t GetPendingCount() const;
+
+			/// <summary>Get the reassembler's counters</summary>
+			/// <returns>Counters since construction</returns>
+			ReassemblyStats GetStats() const;
+
+		protected:
+		private:
+			/// <summary>State of one message being put back together</summary>
+			struct Slot
+			{
+				bool									busy		= false;	// True while the slot holds a message
+				sockaddr_in								source		= {};		// Sender of the message
+				uint32_t								id			= 0;		// Sender's id of the message
+				uint32_t								size		= 0;		// Size of the message
+				uint32_t								stride		= 0;		// Payload bytes of every fragment but the last
+				uint32_t								count		= 0;		// Number of fragments
+				uint32_t								received	= 0;		// Number of distinct fragments received
+				std::chrono::steady_clock::time_point	started;				// Time the first fragment arrived
+				std::vector<char>						data;					// Message storage, maxMessageSize bytes
+				std::vector<uint64_t>					bitmap;					// One bit per fragment received
+			};
+
+			/// <summary>Sender and id of a message that completed</summary>
+			struct CompletedMessage
+			{
+				bool									used		= false;	// True once the entry has been written
+				sockaddr_in								source		= {};		// Sender of the message
+				uint32_t								id			= 0;		// Sender's id of the message
+			};
+
+			/// <summary>Check if a message is one of the recently completed ones</summary>
+			/// <param name="source"> -[in]- Sender of the message</param>
+			/// <param name="id"> -[in]- Sender's id of the message</param>
+			/// <returns>True if the message completed recently</returns>
+			bool RecentlyCompleted(const sockaddr_in& source, const uint32_t id) const;
+
+			/// <summary>Finds the slot of a message, or claims one for it</summary>
+			/// <param name="source"> -[in]- Sender of the message</param>
+			/// <param name="id"> -[in]- Sender's id of the message</param>
+			/// <param name="now"> -[in]- Current time</param>
+			/// <param name="created"> -[out]- True if the slot was claimed for this message</param>
+			/// <returns>Index of the slot</returns>
+			uint32_t FindSlot(const sockaddr_in& source, const uint32_t id, const std::chrono::steady_clock::time_point now, bool& created);
+
+			std::vector<Slot>			mSlots;					// Every slot, allocated up front
+			uint32_t					mMaxMessageSize;		// Largest message accepted
+			std::chrono::milliseconds	mTimeout;				// Longest a message may take to complete
+			uint32_t					mLastSlot;				// Slot of the last fragment, the next one usually shares it
+			uint32_t					mCompletedSlot;			// Slot handed out by the last Receive, released by the next
+			uint32_t					mPending;				// Number of messages still missing fragments
+			std::array<CompletedMessage, UDP_REASSEMBLER_RECENT_COUNT>	mRecent;	// Recently completed messages, oldest overwritten first
+			uint32_t					mNextRecent;			// Entry of mRecent written by the next completion
+			ReassemblyStats				mStats;					// Counters
+		};
+	}
+}
+
+#endif		// CPP_UDP_FRAGMENTER
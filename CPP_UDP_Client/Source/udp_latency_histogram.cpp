@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_latency_histogram.cpp
+//!
+//! @brief		Implementation of the latency histogram
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_latency_histogram.h"	// Latency Histogram Class
+#include	<bit>						// std::countl_zero
+#include	<cstring>					// memset
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		LatencyHistogram::LatencyHistogram()
+		{
+			Reset();
+		}
+
+		void LatencyHistogram::Record(const uint64_t nanoseconds)
+		{
+			mBuckets[BucketOf(nanoseconds)]++;
+			mTotal += static_cast<double>(nanoseconds);
+			mMin = (mCount == 0 || nanoseconds < mMin) ? nanoseconds : mMin;
+			mMax = (nanoseconds > mMax) ? nanoseconds : mMax;
+			mCount++;
+		}
+
+		void LatencyHistogram::Reset()
+		{
+			memset(mBuckets, 0, sizeof(mBuckets));
+			mCount	= 0;
+			mMin	= 0;
+			mMax	= 0;
+			mTotal	= 0;
+		}
+
+		uint64_t LatencyHistogram::Count() const
+		{
+			return mCount;
+		}
+
+		uint64_t LatencyHistogram::Min() const
+		{
+			return mMin;
+		}
+
+		uint64_t LatencyHistogram::Max() const
+		{
+			return mMax;
+		}
+
+		double LatencyHistogram::Mean() const
+		{
+			return mCount > 0 ? mTotal / static_cast<double>(mCount) : 0;
+		}
+
+		uint64_t LatencyHistogram::Percentile(const double percentile) const
+		{
+			if (mCount == 0)
+			{
+				return 0;
+			}
+
+			// Rank of the sample the percentile lands on, counting from 1.
+			uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(mCount) + 0.5);
+			rank = rank < 1 ? 1 : (rank > mCount ? mCount : rank);
+
+			uint64_t seen = 0;
+			for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++)
+			{
+				seen += mBuckets[i];
+
+				if (seen >= rank)
+				{
+					// Never report past what was actually seen.
+					uint64_t bound = UpperBoundOf(i);
+					return bound < mMax ? bound : mMax;
+				}
+			}
+
+			return mMax;
+		}
+
+		std::string LatencyHistogram::Summary() const
+		{
+			return "count " + std::to_string(mCount) +
+				" min " + std::to_string(Min()) +
+				" p50 " + std::to_string(Percentile(50)) +
+				" p90 " + std::to_string(Percentile(90)) +
+				" p99 " + std::to_string(Percentile(99)) +
+				" p99.9 " + std::to_string(Percentile(99.9)) +
+				" max " + std::to_string(Max()) + " ns";
+		}
+
+		uint32_t LatencyHistogram::BucketOf(const uint64_t value)
+		{
+			if (value < LATENCY_SUB_BUCKETS)
+			{
+				return static_cast<uint32_t>(value);
+			}
+
+			// Power of two range first, then the linear step inside it.
+			uint32_t exponent = 63 - static_cast<uint32_t>(std::countl_zero(value));
+			uint32_t step = static_cast<uint32_t>(value >> (exponent - 4)) & (LATENCY_SUB_BUCKETS - 1);
+
+			return (exponent - 3) * LATENCY_SUB_BUCKETS + step;
+		}
+
+		uint64_t LatencyHistogram::UpperBoundOf(const uint32_t bucket)
+		{
+			if (bucket < LATENCY_SUB_BUCKETS)
+			{
+				return bucket;
+			}
+
+			uint32_t exponent = bucket / LATENCY_SUB_BUCKETS + 3;
+			uint64_t step = bucket % LATENCY_SUB_BUCKETS;
+
+			return ((LATENCY_SUB_BUCKETS + step + 1) << (exponent - 4)) - 1;
+		}
+	}
+}
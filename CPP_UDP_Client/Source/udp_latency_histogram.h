@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_latency_histogram.h
+//!
+//! @brief		A fixed-size log-linear histogram for latency measurements.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <cstdint>						// Standard integer types
+#include <string>						// Summary strings
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_LATENCY_HISTOGRAM	// Define the cpp UDP latency histogram class.
+#define     CPP_UDP_LATENCY_HISTOGRAM
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint32_t	LATENCY_SUB_BUCKETS			= 16;
+		constexpr static uint32_t	LATENCY_BUCKET_COUNT		= 64 * LATENCY_SUB_BUCKETS;
+
+		/// <summary>Counts nanosecond samples in power-of-two ranges split into 16 linear steps, so any value is
+		/// reported within about 6%. Recording never allocates; a histogram is meant for one thread.</summary>
+		class LatencyHistogram
+		{
+		public:
+			/// <summary>Default Constructor, an empty histogram</summary>
+			LatencyHistogram();
+
+			/// <summary>Adds a sample</summary>
+			/// <param name="nanoseconds"> -[in]- Measured latency</param>
+			void Record(const uint64_t nanoseconds);
+
+			/// <summary>Removes every sample</summary>
+			void Reset();
+
+			/// <summary>Get the number of samples</summary>
+			/// <returns>Number of samples</returns>
+			uint64_t Count() const;
+
+			/// <summary>Get the smallest sample</summary>
+			/// <returns>Smallest sample, 0 if empty</returns>
+			uint64_t Min() const;
+
+			/// <summary>Get the largest sample</summary>
+			/// <returns>Largest sample, 0 if empty</returns>
+			uint64_t Max() const;
+
+			/// <summary>Get the mean of the samples</summary>
+			/// <returns>Mean sample, 0 if empty</returns>
+			double Mean() const;
+
+			/// <summary>Get the value below which a share of the samples fall</summary>
+			/// <param name="percentile"> -[in]- Share of the samples, 0 - 100</param>
+			/// <returns>Upper bound of the bucket holding the percentile, 0 if empty</returns>
+			uint64_t Percentile(const double percentile) const;
+
+			/// <summary>Formats the usual percentiles on one line</summary>
+			/// <returns>Count, min, p50, p90, p99, p99.9 and max in nanoseconds</returns>
+			std::string Summary() const;
+
+		protected:
+		private:
+			/// <summary>Get the bucket a value falls in</summary>
+			static uint32_t BucketOf(const uint64_t value);
+
+			/// <summary>Get the largest value a bucket holds</summary>
+			static uint64_t UpperBoundOf(const uint32_t bucket);
+
+			uint64_t					mBuckets[LATENCY_BUCKET_COUNT];	// Sample count per bucket
+			uint64_t					mCount;					// Number of samples
+			uint64_t					mMin;					// Smallest sample
+			uint64_t					mMax;					// Largest sample
+			double						mTotal;					// Sum of the samples
+		};
+	}
+}
+
+#endif		// CPP_UDP_LATENCY_HISTOGRAM
@@ -0,0 +1,238 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_pacer.cpp
+//!
+//! @brief		Implementation of the udp pacer
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_pacer.h"				// UDP Pacer Class
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		UDP_Pacer::UDP_Pacer(UDP_Client& client) : mClient(client)
+		{
+			mMode			= PacingMode::USER_SPACE;
+			mDefaultRate	= {};
+			mSpinThreshold	= UDP_PACER_DEFAULT_SPIN_NS;
+		}
+
+		int8_t UDP_Pacer::SetMode(const PacingMode mode)
+		{
+			if (mode == PacingMode::KERNEL_TXTIME && mClient.EnableTransmitTime(true) < 0)
+			{
+				return -1;
+			}
+
+			std::lock_guard<std::mutex> lock(mLock);
+			mMode = mode;
+			return 0;
+		}
+
+		PacingMode UDP_Pacer::GetMode()
+		{
+			std::lock_guard<std::mutex> lock(mLock);
+			return mMode;
+		}
+
+		void UDP_Pacer::SetDefaultRate(const PacingRate& rate)
+		{
+			std::lock_guard<std::mutex> lock(mLock);
+			mDefaultRate = rate;
+
+			for (auto& entry : mDestinations)
+			{
+				entry.second.rate = entry.second.custom ? entry.second.rate : rate;
+			}
+
+			for (auto& entry : mGroups)
+			{
+				entry.second.rate = entry.second.custom ? entry.second.rate : rate;
+			}
+		}
+
+		void UDP_Pacer::SetDestinationRate(const Destination& destination, const PacingRate& rate)
+		{
+			std::lock_guard<std::mutex> lock(mLock);
+			Bucket& bucket = mDestinations[KeyOf(destination)];
+			bucket.rate = rate;
+			bucket.custom = true;
+		}
+
+		void UDP_Pacer::SetGroupRate(const MulticastGroupId id, const PacingRate& rate)
+		{
+			std::lock_guard<std::mutex> lock(mLock);
+			Bucket& bucket = mGroups[id];
+			bucket.rate = rate;
+			bucket.custom = true;
+		}
+
+		int8_t UDP_Pacer::RemoveDestination(const Destination& destination)
+		{
+			std::lock_guard<std::mutex> lock(mLock);
+			return mDestinations.erase(KeyOf(destination)) > 0 ? 0 : -1;
+		}
+
+		void UDP_Pacer::SetSpinThreshold(const uint64_t nanoseconds)
+		{
+			std::lock_guard<std::mutex> lock(mLock);
+			mSpinThreshold = nanoseconds;
+		}
+
+		int32_t UDP_Pacer::SendUnicast(const char* buffer, const uint32_t size, const Destination& destination)
+		{
+			uint64_t departure = 0;
+			PacingMode mode = PacingMode::USER_SPACE;
+
+			{
+				std::lock_guard<std::mutex> lock(mLock);
+				auto found = mDestinations.try_emplace(KeyOf(destination), Bucket{ mDefaultRate, false, 0 });
+				departure = Schedule(found.first->second, size);
+				mode = mMode;
+			}
+
+			// Without SO_TXTIME the kernel would send at once, the wait has to happen here.
+			if (mode == PacingMode::KERNEL_TXTIME && !mClient.IsTransmitTimeEnabled())
+			{
+				mode = PacingMode::USER_SPACE;
+			}
+
+			WaitForDeparture(departure, mode);
+
+			return mode == PacingMode::KERNEL_TXTIME ? mClient.SendUnicastAt(buffer, size, destination, departure)
+				: mClient.SendUnicast(buffer, size, destination);
+		}
+
+		int32_t UDP_Pacer::SendMulticast(const char* buffer, const uint32_t size, const MulticastGroupId id)
+		{
+			uint64_t departure = 0;
+			PacingMode mode = PacingMode::USER_SPACE;
+
+			{
+				std::lock_guard<std::mutex> lock(mLock);
+				auto found = mGroups.try_emplace(id, Bucket{ mDefaultRate, false, 0 });
+				departure = Schedule(found.first->second, size);
+				mode = mMode;
+			}
+
+			// Without SO_TXTIME the kernel would send at once, the wait has to happen here.
+			if (mode == PacingMode::KERNEL_TXTIME && !mClient.IsTransmitTimeEnabled())
+			{
+				mode = PacingMode::USER_SPACE;
+			}
+
+			WaitForDeparture(departure, mode);
+
+			return mode == PacingMode::KERNEL_TXTIME ? mClient.SendMulticastToGroupAt(buffer, size, id, departure)
+				: mClient.SendMulticastToGroup(buffer, size, id);
+		}
+
+		size_t UDP_Pacer::DestinationHash::operator()(const DestinationKey& key) const
+		{
+			uint64_t hash = 14695981039346656037ULL;
+
+			for (uint8_t byte : key)
+			{
+				hash = (hash ^ byte) * 1099511628211ULL;
+			}
+
+			return static_cast<size_t>(hash);
+		}
+
+		UDP_Pacer::DestinationKey UDP_Pacer::KeyOf(const Destination& destination)
+		{
+			DestinationKey key{};
+
+			memcpy(key.data(), &destination.address.sin_addr, sizeof(destination.address.sin_addr));
+			memcpy(key.data() + 4, &destination.address.sin_port, sizeof(destination.address.sin_port));
+
+			return key;
+		}
+
+		uint64_t UDP_Pacer::Schedule(Bucket& bucket, const uint32_t size)
+		{
+			uint64_t now = Now();
+
+			// Time on the wire the datagram is charged, the slower of the two limits.
+			uint64_t cost = 0;
+			if (bucket.rate.bitsPerSecond > 0)
+			{
+				cost = static_cast<uint64_t>(size) * 8 * 1000000000ULL / bucket.rate.bitsPerSecond;
+			}
+
+			if (bucket.rate.packetsPerSecond > 0)
+			{
+				cost = std::max<uint64_t>(cost, 1000000000ULL / bucket.rate.packetsPerSecond);
+			}
+
+			if (cost == 0)
+			{
+				return now;
+			}
+
+			// An idle bucket may run ahead of its rate by the burst, then sends are spaced by their cost.
+			uint64_t tolerance = static_cast<uint64_t>(bucket.rate.burstPackets > 1 ? bucket.rate.burstPackets - 1 : 0) * cost;
+			bucket.paidOff = std::max(bucket.paidOff, now);
+
+			uint64_t departure = bucket.paidOff > now + tolerance ? bucket.paidOff - tolerance : now;
+			bucket.paidOff += cost;
+
+			return departure;
+		}
+
+		uint64_t UDP_Pacer::Now()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		void UDP_Pacer::WaitUntil(const uint64_t departure)
+		{
+			uint64_t now = Now();
+			uint64_t spin = 0;
+
+			{
+				std::lock_guard<std::mutex> lock(mLock);
+				spin = mSpinThreshold;
+			}
+
+			// Sleep through most of the gap, the scheduler is too coarse for the last stretch.
+			if (departure > now + spin)
+			{
+				std::this_thread::sleep_for(std::chrono::nanoseconds(departure - now - spin));
+			}
+
+			while (Now() < departure)
+			{
+			}
+		}
+
+		void UDP_Pacer::WaitForDeparture(const uint64_t departure, const PacingMode mode)
+		{
+			// The qdisc holds datagrams up to the lookahead, beyond it the socket buffer would fill with waiting sends.
+			if (mode == PacingMode::KERNEL_TXTIME)
+			{
+				if (departure > Now() + UDP_PACER_KERNEL_LOOKAHEAD_NS)
+				{
+					WaitUntil(departure - UDP_PACER_KERNEL_LOOKAHEAD_NS);
+				}
+
+				return;
+			}
+
+			WaitUntil(departure);
+		}
+	}
+}
@@ -0,0 +1,168 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_pacer.h
+//!
+//! @brief		Spreads unicast and multicast sends out at a configured rate.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "udp_client.h"					// UDP Client Class
+#include <array>						// Destination keys
+#include <mutex>						// Bucket table
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_PACER				// Define the cpp UDP pacer class.
+#define     CPP_UDP_PACER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint64_t	UDP_PACER_DEFAULT_SPIN_NS		= 50000;
+		constexpr static uint64_t	UDP_PACER_KERNEL_LOOKAHEAD_NS	= 10000000;
+
+		/// <summary>Rate a destination or group is paced at, whichever of the two limits is slower applies</summary>
+		struct PacingRate
+		{
+			uint64_t			bitsPerSecond	= 0;	// Payload bit rate, 0 for no bit rate limit
+			uint32_t			packetsPerSecond = 0;	// Datagram rate, 0 for no packet rate limit
+			uint32_t			burstPackets	= 1;	// Datagrams that may leave back to back after the bucket has been idle
+		};
+
+		/// <summary>Where the pacer waits for a datagram's departure time</summary>
+		enum class PacingMode : uint8_t
+		{
+			USER_SPACE,			// Sleep, then spin, until the departure time before sending
+			KERNEL_TXTIME,		// Hand the departure time to the fq or etf qdisc through SO_TXTIME
+		};
+
+		/// <summary>Paces sends through a client with one token bucket per unicast destination and per multicast group.
+		/// Each send is given a departure time from its bucket; the pacer either waits for it or leaves the wait to the
+		/// kernel. Buckets are shared by every thread sending through the pacer.</summary>
+		class UDP_Pacer
+		{
+		public:
+			/// <summary>Constructor taking the client whose sockets carry the sends</summary>
+			/// <param name="client"> -[in]- Client to send through, must outlive the pacer</param>
+			UDP_Pacer(UDP_Client& client);
+
+			UDP_Pacer(const UDP_Pacer&) = delete;
+			UDP_Pacer& operator=(const UDP_Pacer&) = delete;
+
+			/// <summary>Selects where departure times are waited for. KERNEL_TXTIME enables SO_TXTIME on the client, the
+			/// interface must run the fq or etf qdisc for the times to be honoured. Should the client's SO_TXTIME be disabled
+			/// later, sends wait in user space until it is enabled again.</summary>
+			/// <param name="mode"> -[in]- Pacing mode</param>
+			/// <returns>0 if successful, -1 if SO_TXTIME is not available, the mode is left unchanged.</returns>
+			int8_t SetMode(const PacingMode mode);
+
+			/// <summary>Get the pacing mode in use</summary>
+			/// <returns>Pacing mode</returns>
+			PacingMode GetMode();
+
+			/// <summary>Sets the rate of every destination and group without a rate of its own</summary>
+			/// <param name="rate"> -[in]- Rate to pace at, all zero sends unpaced</param>
+			void SetDefaultRate(const PacingRate& rate);
+
+			/// <summary>Sets the rate of one unicast destination</summary>
+			/// <param name="destination"> -[in]- Destination filled by UDP_Client::ResolveDestination</param>
+			/// <param name="rate"> -[in]- Rate to pace at, all zero sends unpaced</param>
+			void SetDestinationRate(const Destination& destination, const PacingRate& rate);
+
+			/// <summary>Sets the rate of one multicast group</summary>
+			/// <param name="id"> -[in]- Group id from UDP_Client::GetMulticastGroupId</param>
+			/// <param name="rate"> -[in]- Rate to pace at, all zero sends unpaced</param>
+			void SetGroupRate(const MulticastGroupId id, const PacingRate& rate);
+
+			/// <summary>Forgets the bucket of a unicast destination no longer sent to, along with any rate set for it. A later 
+			/// send to it starts a fresh bucket at the default rate.</summary>
+			/// <param name="destination"> -[in]- Destination filled by UDP_Client::ResolveDestination</param>
+			/// <returns>0 if successful, -1 if the destination has no bucket.</returns>
+			int8_t RemoveDestination(const Destination& destination);
+
+			/// <summary>Sets how close to a departure time the user space wait stops sleeping and starts spinning</summary>
+			/// <param name="nanoseconds"> -[in]- Spin window, 0 only sleeps</param>
+			void SetSpinThreshold(const uint64_t nanoseconds);
+
+			/// <summary>Sends a unicast message once its destination's bucket allows it</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="destination"> -[in]- Destination filled by UDP_Client::ResolveDestination</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendUnicast(const char* buffer, const uint32_t size, const Destination& destination);
+
+			/// <summary>Sends a multicast message once its group's bucket allows it</summary>
+			/// <param name="buffer"> -[in]- Buffer to be sent</param>
+			/// <param name="size"> -[in]- Size to be sent</param>
+			/// <param name="id"> -[in]- Group id from UDP_Client::GetMulticastGroupId</param>
+			/// <returns>0+ if successful (number bytes sent), -1 if fails. Call UDP_Client::GetLastError to find out more.</returns>
+			int32_t SendMulticast(const char* buffer, const uint32_t size, const MulticastGroupId id);
+
+		protected:
+		private:
+			/// <summary>Token bucket kept as the time its debt is paid off (GCRA)</summary>
+			struct Bucket
+			{
+				PacingRate			rate		= {};		// Rate of the bucket
+				bool				custom		= false;	// True if the rate was set for this bucket, not taken from the default
+				uint64_t			paidOff		= 0;		// Time the bucket's sends so far are paid for, nanoseconds
+			};
+
+			/// <summary>IPv4 address and port of a destination, network byte order</summary>
+			using DestinationKey = std::array<uint8_t, 6>;
+
+			/// <summary>FNV-1a over a destination key</summary>
+			struct DestinationHash
+			{
+				size_t operator()(const DestinationKey& key) const;
+			};
+
+			/// <summary>Builds the bucket key of a destination</summary>
+			/// <param name="destination"> -[in]- Resolved destination</param>
+			/// <returns>Key of the destination</returns>
+			static DestinationKey KeyOf(const Destination& destination);
+
+			/// <summary>Takes a datagram's cost from a bucket</summary>
+			/// <param name="bucket"> -[in/out]- Bucket to charge</param>
+			/// <param name="size"> -[in]- Size of the datagram</param>
+			/// <returns>Departure time in nanoseconds of std::chrono::steady_clock</returns>
+			static uint64_t Schedule(Bucket& bucket, const uint32_t size);
+
+			/// <summary>Get the current time of std::chrono::steady_clock</summary>
+			/// <returns>Nanoseconds since the clock's epoch</returns>
+			static uint64_t Now();
+
+			/// <summary>Waits for a departure time, sleeping while it is far and spinning once it is close</summary>
+			/// <param name="departure"> -[in]- Time to wait for</param>
+			void WaitUntil(const uint64_t departure);
+
+			/// <summary>Waits until a departure time is close enough to be handed to the kernel or is due</summary>
+			/// <param name="departure"> -[in]- Departure time of the datagram</param>
+			/// <param name="mode"> -[in]- Pacing mode the departure time was scheduled under</param>
+			void WaitForDeparture(const uint64_t departure, const PacingMode mode);
+
+			UDP_Client&					mClient;				// Client carrying the sends
+			PacingMode					mMode;					// Where departure times are waited for
+			PacingRate					mDefaultRate;			// Rate of buckets without their own
+			uint64_t					mSpinThreshold;			// Spin window of the user space wait
+			std::unordered_map<DestinationKey, Bucket, DestinationHash>	mDestinations;	// Bucket per unicast destination
+			std::unordered_map<MulticastGroupId, Bucket>				mGroups;		// Bucket per multicast group
+			std::mutex					mLock;					// Guards the buckets and rates
+		};
+	}
+}
+
+#endif		// CPP_UDP_PACER
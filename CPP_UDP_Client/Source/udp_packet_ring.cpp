@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_packet_ring.cpp
+//!
+//! @brief		Implementation of the udp packet ring
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_packet_ring.h"			// UDP Packet Ring Class
+#include	<new>						// Aligned allocation
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		UDP_PacketRing::UDP_PacketRing(const uint32_t slotCount, const uint32_t slotSize)
+		{
+			uint32_t capacity = 1;
+			while (capacity < slotCount)
+			{
+				capacity <<= 1;
+			}
+
+			// Round each slot up to whole cache lines so neighbouring slots never share one.
+			size_t stride = (static_cast<size_t>(slotSize) + UDP_CACHE_LINE_SIZE - 1) & ~static_cast<size_t>(UDP_CACHE_LINE_SIZE - 1);
+
+			mHead		= 0;
+			mCachedTail	= 0;
+			mTail		= 0;
+			mCachedHead	= 0;
+			mMask		= capacity - 1;
+			mSlots		= new RingSlot[capacity];
+			mStorage	= static_cast<char*>(::operator new(stride * capacity, std::align_val_t(UDP_CACHE_LINE_SIZE)));
+
+			for (uint32_t i = 0; i < capacity; i++)
+			{
+				mSlots[i].data = mStorage + stride * i;
+				mSlots[i].capacity = slotSize;
+			}
+		}
+
+		UDP_PacketRing::~UDP_PacketRing()
+		{
+			delete[] mSlots;
+			::operator delete(mStorage, std::align_val_t(UDP_CACHE_LINE_SIZE));
+		}
+
+		uint32_t UDP_PacketRing::Capacity() const
+		{
+			return mMask + 1;
+		}
+
+		uint32_t UDP_PacketRing::Depth() const
+		{
+			return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+		}
+
+		uint32_t UDP_PacketRing::WritableCount()
+		{
+			uint32_t tail = mTail.load(std::memory_order_relaxed);
+
+			// Only look at the consumer's index when the cached view says the ring is full.
+			if (tail - mCachedHead > mMask)
+			{
+				mCachedHead = mHead.load(std::memory_order_acquire);
+			}
+
+			return Capacity() - (tail - mCachedHead);
+		}
+
+		RingSlot& UDP_PacketRing::WritableSlot(const uint32_t offset)
+		{
+			return mSlots[(mTail.load(std::memory_order_relaxed) + offset) & mMask];
+		}
+
+		void UDP_PacketRing::Publish(const uint32_t count)
+		{
+			mTail.store(mTail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+		}
+
+		uint32_t UDP_PacketRing::ReadableCount()
+		{
+			uint32_t head = mHead.load(std::memory_order_relaxed);
+
+			// Only look at the producer's index when the cached view says the ring is empty.
+			if (mCachedTail == head)
+			{
+				mCachedTail = mTail.load(std::memory_order_acquire);
+			}
+
+			return mCachedTail - head;
+		}
+
+		const RingSlot& UDP_PacketRing::ReadableSlot(const uint32_t offset) const
+		{
+			return mSlots[(mHead.load(std::memory_order_relaxed) + offset) & mMask];
+		}
+
+		void UDP_PacketRing::Consume(const uint32_t count)
+		{
+			mHead.store(mHead.load(std::memory_order_relaxed) + count, std::memory_order_release);
+		}
+	}
+}
@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_packet_ring.h
+//!
+//! @brief		A lock-free single producer, single consumer ring of packet slots.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "udp_client.h"					// Socket types and SendType
+#include <atomic>						// Ring indexes
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_PACKET_RING			// Define the cpp UDP packet ring class.
+#define     CPP_UDP_PACKET_RING
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint32_t	UDP_CACHE_LINE_SIZE		= 64;
+
+		/// <summary>Represents one fixed-size packet slot of the ring, padded to its own cache line</summary>
+		struct alignas(UDP_CACHE_LINE_SIZE) RingSlot
+		{
+			char*				data		= nullptr;				// Slot storage, RingSlot::capacity bytes
+			uint32_t			capacity	= 0;					// Size of the slot storage
+			uint32_t			size		= 0;					// Number of bytes received
+			sockaddr_in			source		= {};					// Address and port of the sender, network byte order
+			sockaddr_in			group		= {};					// Multicast group and port the datagram was sent to, zero for unicast and broadcast
+			uint64_t			timestamp	= 0;					// Kernel arrival time in nanoseconds since the epoch, needs EnableReceiveTimestamps
+			SOCKET				socket		= INVALID_SOCKET;		// Socket the datagram arrived on
+			SendType			type		= SendType::UNICAST;	// Kind of socket the datagram arrived on
+			bool				truncated	= false;				// True if the datagram was larger than the slot
+		};
+
+		/// <summary>A preallocated ring of packet slots shared by exactly one producer thread and one consumer thread.</summary>
+		class UDP_PacketRing
+		{
+		public:
+			/// <summary>Constructor to allocate every slot up front</summary>
+			/// <param name="slotCount"> -[in]- Number of slots, rounded up to a power of two</param>
+			/// <param name="slotSize"> -[in]- Size of each slot's storage</param>
+			UDP_PacketRing(const uint32_t slotCount, const uint32_t slotSize);
+
+			/// <summary>Default Deconstructor</summary>
+			~UDP_PacketRing();
+
+			UDP_PacketRing(const UDP_PacketRing&) = delete;
+			UDP_PacketRing& operator=(const UDP_PacketRing&) = delete;
+
+			/// <summary>Get the number of slots in the ring</summary>
+			/// <returns>Number of slots</returns>
+			uint32_t Capacity() const;
+
+			/// <summary>Either side: get the number of filled slots from both indexes, unlike ReadableCount it never 
+			/// answers from a cached view</summary>
+			/// <returns>Number of filled slots</returns>
+			uint32_t Depth() const;
+
+			/// <summary>Producer: get the number of slots that can be filled</summary>
+			/// <returns>Number of free slots</returns>
+			uint32_t WritableCount();
+
+			/// <summary>Producer: get a free slot, 0 is the next slot to be published</summary>
+			/// <param name="offset"> -[in]- Offset from the next slot to be published, less than WritableCount</param>
+			/// <returns>Reference to the slot</returns>
+			RingSlot& WritableSlot(const uint32_t offset);
+
+			/// <summary>Producer: hands filled slots to the consumer</summary>
+			/// <param name="count"> -[in]- Number of slots filled</param>
+			void Publish(const uint32_t count);
+
+			/// <summary>Consumer: get the number of slots waiting to be read</summary>
+			/// <returns>Number of filled slots</returns>
+			uint32_t ReadableCount();
+
+			/// <summary>Consumer: get a filled slot, 0 is the oldest</summary>
+			/// <param name="offset"> -[in]- Offset from the oldest slot, less than ReadableCount</param>
+			/// <returns>Reference to the slot</returns>
+			const RingSlot& ReadableSlot(const uint32_t offset) const;
+
+			/// <summary>Consumer: hands read slots back to the producer</summary>
+			/// <param name="count"> -[in]- Number of slots read</param>
+			void Consume(const uint32_t count);
+
+		protected:
+		private:
+			// Each index lives on its own cache line with the other side's cached copy, so the
+			// producer and consumer only share a line when one has to refresh its view.
+			alignas(UDP_CACHE_LINE_SIZE) std::atomic<uint32_t>	mHead;			// Next slot to be read, written by the consumer
+			uint32_t											mCachedTail;	// Consumer's last view of mTail
+			alignas(UDP_CACHE_LINE_SIZE) std::atomic<uint32_t>	mTail;			// Next slot to be written, written by the producer
+			uint32_t											mCachedHead;	// Producer's last view of mHead
+			alignas(UDP_CACHE_LINE_SIZE) uint32_t				mMask;			// Slot index mask
+			RingSlot*											mSlots;			// Slot headers
+			char*												mStorage;		// Slot storage, one cache aligned block
+		};
+	}
+}
+
+#endif		// CPP_UDP_PACKET_RING
@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_socket_filter.cpp
+//!
+//! @brief		Implementation of the udp socket filter builder
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_socket_filter.h"		// UDP Socket Filter Class
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		// Classic BPF encodings, spelled out so the builder also compiles where linux/filter.h does not exist.
+		constexpr static uint16_t	FILTER_LOAD_WORD		= 0x00 | 0x00 | 0x20;	// BPF_LD | BPF_W | BPF_ABS
+		constexpr static uint16_t	FILTER_LOAD_HALF		= 0x00 | 0x08 | 0x20;	// BPF_LD | BPF_H | BPF_ABS
+		constexpr static uint16_t	FILTER_LOAD_BYTE		= 0x00 | 0x10 | 0x20;	// BPF_LD | BPF_B | BPF_ABS
+		constexpr static uint16_t	FILTER_LOAD_LENGTH		= 0x00 | 0x00 | 0x80;	// BPF_LD | BPF_W | BPF_LEN
+		constexpr static uint16_t	FILTER_JUMP_ALWAYS		= 0x05 | 0x00;			// BPF_JMP | BPF_JA
+		constexpr static uint16_t	FILTER_JUMP_EQUAL		= 0x05 | 0x10 | 0x00;	// BPF_JMP | BPF_JEQ | BPF_K
+		constexpr static uint16_t	FILTER_JUMP_GREATER_EQ	= 0x05 | 0x30 | 0x00;	// BPF_JMP | BPF_JGE | BPF_K
+		constexpr static uint16_t	FILTER_RETURN			= 0x06 | 0x00;			// BPF_RET | BPF_K
+
+		// The program sees the datagram from its UDP header, the IP header sits at the kernel's network offset.
+		constexpr static uint32_t	FILTER_PAYLOAD_OFFSET	= 8;
+		constexpr static uint32_t	FILTER_SOURCE_OFFSET	= static_cast<uint32_t>(-0x100000 + 12);	// SKF_NET_OFF + saddr
+
+		UDP_SocketFilter::UDP_SocketFilter()
+		{
+			mInvalid = false;
+		}
+
+		UDP_SocketFilter& UDP_SocketFilter::RequireBytes(const uint32_t offset, std::span<const uint8_t> bytes)
+		{
+			// Compare a word at a time, then the tail, each mismatch jumps to this rule's reject.
+			std::vector<std::pair<uint16_t, uint32_t>> loads;
+			size_t position = 0;
+
+			while (position < bytes.size())
+			{
+				size_t width = std::min<size_t>(bytes.size() - position, 4);
+				width = (width == 3) ? 2 : width;
+
+				uint32_t value = 0;
+				for (size_t i = 0; i < width; i++)
+				{
+					value = (value << 8) | bytes[position + i];
+				}
+
+				uint16_t code = (width == 4) ? FILTER_LOAD_WORD : (width == 2) ? FILTER_LOAD_HALF : FILTER_LOAD_BYTE;
+				loads.push_back({ code, value });
+				position += width;
+			}
+
+			if (loads.empty())
+			{
+				return *this;
+			}
+
+			if (loads.size() * 2 > 255)
+			{
+				mInvalid = true;
+				return *this;
+			}
+
+			// Layout: (load, compare) per chunk, jump over the reject, reject.
+			size_t chunkOffset = 0;
+			for (size_t i = 0; i < loads.size(); i++)
+			{
+				uint8_t toReject = static_cast<uint8_t>((loads.size() - i - 1) * 2 + 1);
+
+				Emit(loads[i].first, FILTER_PAYLOAD_OFFSET + offset + static_cast<uint32_t>(chunkOffset));
+				Emit(FILTER_JUMP_EQUAL, loads[i].second, 0, toReject);
+
+				chunkOffset += (loads[i].first == FILTER_LOAD_WORD) ? 4 : (loads[i].first == FILTER_LOAD_HALF) ? 2 : 1;
+			}
+
+			Emit(FILTER_JUMP_ALWAYS, 1);
+			Emit(FILTER_RETURN, 0);
+			return *this;
+		}
+
+		UDP_SocketFilter& UDP_SocketFilter::RequireByteIn(const uint32_t offset, std::span<const uint8_t> values)
+		{
+			if (values.empty() || values.size() > UDP_FILTER_MAX_SET_SIZE)
+			{
+				mInvalid = true;
+				return *this;
+			}
+
+			std::vector<uint32_t> set(values.begin(), values.end());
+
+			Emit(FILTER_LOAD_BYTE, FILTER_PAYLOAD_OFFSET + offset);
+			EmitSetMatch(set);
+			return *this;
+		}
+
+		UDP_SocketFilter& UDP_SocketFilter::RequireSourceIn(std::span<const in_addr> sources)
+		{
+			if (sources.empty() || sources.size() > UDP_FILTER_MAX_SET_SIZE)
+			{
+				mInvalid = true;
+				return *this;
+			}
+
+			// Loads are big endian, as is the address.
+			std::vector<uint32_t> set;
+			set.reserve(sources.size());
+			for (const auto& source : sources)
+			{
+				set.push_back(ntohl(source.s_addr));
+			}
+
+			Emit(FILTER_LOAD_WORD, FILTER_SOURCE_OFFSET);
+			EmitSetMatch(set);
+			return *this;
+		}
+
+		UDP_SocketFilter& UDP_SocketFilter::RequireMinimumSize(const uint32_t size)
+		{
+			Emit(FILTER_LOAD_LENGTH, 0);
+			Emit(FILTER_JUMP_GREATER_EQ, FILTER_PAYLOAD_OFFSET + size, 1, 0);
+			Emit(FILTER_RETURN, 0);
+			return *this;
+		}
+
+		bool UDP_SocketFilter::IsInvalid() const
+		{
+			return mInvalid || mProgram.size() + 1 > UDP_FILTER_MAX_INSTRUCTIONS;
+		}
+
+		std::vector<SocketFilterInstruction> UDP_SocketFilter::Build() const
+		{
+			std::vector<SocketFilterInstruction> program = mProgram;
+
+			// Every rule held, keep the whole datagram.
+			SocketFilterInstruction accept{};
+			accept.code = FILTER_RETURN;
+			accept.k = 0xFFFFFFFF;
+			program.push_back(accept);
+
+			return program;
+		}
+
+		void UDP_SocketFilter::Emit(const uint16_t code, const uint32_t k, const uint8_t jt, const uint8_t jf)
+		{
+			SocketFilterInstruction instruction{};
+			instruction.code = code;
+			instruction.jt = jt;
+			instruction.jf = jf;
+			instruction.k = k;
+			mProgram.push_back(instruction);
+		}
+
+		void UDP_SocketFilter::EmitSetMatch(std::span<const uint32_t> values)
+		{
+			// A match jumps past the reject that closes the set, no match falls into it.
+			for (size_t i = 0; i < values.size(); i++)
+			{
+				Emit(FILTER_JUMP_EQUAL, values[i], static_cast<uint8_t>(values.size() - i), 0);
+			}
+
+			Emit(FILTER_RETURN, 0);
+		}
+	}
+}
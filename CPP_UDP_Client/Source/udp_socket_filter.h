@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_socket_filter.h
+//!
+//! @brief		A builder for classic BPF socket filters that reject datagrams in the kernel.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "udp_client.h"					// Socket types
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_SOCKET_FILTER		// Define the cpp UDP socket filter class.
+#define     CPP_UDP_SOCKET_FILTER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint32_t	UDP_FILTER_MAX_INSTRUCTIONS	= 4096;
+		constexpr static uint32_t	UDP_FILTER_MAX_SET_SIZE		= 200;
+
+		/// <summary>Builds a socket filter from rules that must all hold for a datagram to be accepted. 
+		/// Payload offsets count from the first byte after the UDP header. Datagrams too short for a rule are rejected.</summary>
+		class UDP_SocketFilter
+		{
+		public:
+			/// <summary>Default Constructor, an empty filter accepts everything</summary>
+			UDP_SocketFilter();
+
+			/// <summary>Requires the payload to hold the given bytes at an offset, such as a magic number at offset 0</summary>
+			/// <param name="offset"> -[in]- Offset of the bytes in the payload</param>
+			/// <param name="bytes"> -[in]- Bytes that must match</param>
+			/// <returns>This filter, to chain further rules</returns>
+			UDP_SocketFilter& RequireBytes(const uint32_t offset, std::span<const uint8_t> bytes);
+
+			/// <summary>Requires the payload byte at an offset to be one of a set, such as a message type</summary>
+			/// <param name="offset"> -[in]- Offset of the byte in the payload</param>
+			/// <param name="values"> -[in]- Accepted values, at most UDP_FILTER_MAX_SET_SIZE</param>
+			/// <returns>This filter, to chain further rules</returns>
+			UDP_SocketFilter& RequireByteIn(const uint32_t offset, std::span<const uint8_t> values);
+
+			/// <summary>Requires the datagram's source address to be one of a set</summary>
+			/// <param name="sources"> -[in]- Accepted IPv4 sources, network byte order, at most UDP_FILTER_MAX_SET_SIZE</param>
+			/// <returns>This filter, to chain further rules</returns>
+			UDP_SocketFilter& RequireSourceIn(std::span<const in_addr> sources);
+
+			/// <summary>Requires the payload to be at least a given size</summary>
+			/// <param name="size"> -[in]- Minimum payload size</param>
+			/// <returns>This filter, to chain further rules</returns>
+			UDP_SocketFilter& RequireMinimumSize(const uint32_t size);
+
+			/// <summary>Check if a rule could not be built, such as a set that is too large</summary>
+			/// <returns>true if the filter is unusable</returns>
+			bool IsInvalid() const;
+
+			/// <summary>Get the finished program</summary>
+			/// <returns>The rules followed by the final accept</returns>
+			std::vector<SocketFilterInstruction> Build() const;
+
+		protected:
+		private:
+			/// <summary>Appends an instruction to the program</summary>
+			void Emit(const uint16_t code, const uint32_t k, const uint8_t jt = 0, const uint8_t jf = 0);
+
+			/// <summary>Appends a comparison of the loaded value against a set, falling through to a reject when none match</summary>
+			/// <param name="values"> -[in]- Accepted values</param>
+			void EmitSetMatch(std::span<const uint32_t> values);
+
+			std::vector<SocketFilterInstruction>	mProgram;		// Instructions of every rule so far
+			bool									mInvalid;		// Set when a rule could not be built
+		};
+	}
+}
+
+#endif		// CPP_UDP_SOCKET_FILTER
@@ -0,0 +1,548 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_uring.cpp
+//!
+//! @brief		Implementation of the udp io_uring engine
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include	"udp_uring.h"				// UDP io_uring Class
+#if defined __linux__
+#include	<sys/mman.h>				// Ring mappings
+#include	<sys/syscall.h>				// io_uring system calls
+#endif
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+#if defined __linux__
+		// Operation kinds stored in the top byte of each entry's user data.
+		constexpr static uint64_t	URING_OP_RECEIVE	= 1;
+		constexpr static uint64_t	URING_OP_SYNC		= 2;
+
+		UDP_Uring::UDP_Uring()
+		{
+			mRing				= -1;
+			mRingMemory			= nullptr;
+			mRingMemorySize		= 0;
+			mSqes				= nullptr;
+			mSqesSize			= 0;
+			mSqHead				= nullptr;
+			mSqTail				= nullptr;
+			mSqMask				= 0;
+			mSqArray			= nullptr;
+			mSqPending			= 0;
+			mCqHead				= nullptr;
+			mCqTail				= nullptr;
+			mCqMask				= 0;
+			mCqes				= nullptr;
+			mBufferRing			= nullptr;
+			mBufferRingSize		= 0;
+			mBufferMask			= 0;
+			mBufferSize			= 0;
+			mReceiveHeader		= {};
+			mReadyHead			= 0;
+			mReadyCount			= 0;
+			mSyncSequence		= 0;
+			mSyncResult			= 0;
+			mSyncComplete		= false;
+			mReceiveError		= 0;
+		}
+
+		UDP_Uring::~UDP_Uring()
+		{
+			// Closing the ring cancels every outstanding operation.
+			if (mRing != -1)
+			{
+				close(mRing);
+				mRing = -1;
+			}
+
+			if (mBufferRing != nullptr)
+			{
+				munmap(mBufferRing, mBufferRingSize);
+				mBufferRing = nullptr;
+			}
+
+			if (mSqes != nullptr)
+			{
+				munmap(mSqes, mSqesSize);
+				mSqes = nullptr;
+			}
+
+			if (mRingMemory != nullptr)
+			{
+				munmap(mRingMemory, mRingMemorySize);
+				mRingMemory = nullptr;
+			}
+		}
+
+		int8_t UDP_Uring::Initialize(const uint32_t entries, const uint32_t bufferCount, const uint32_t bufferSize)
+		{
+			if (mRing != -1)
+			{
+				return 0;
+			}
+
+			// The kernel indexes the buffer ring with a mask and a 16 bit id.
+			if (bufferCount == 0 || (bufferCount & (bufferCount - 1)) != 0 || bufferCount > 32768)
+			{
+				return -1;
+			}
+
+			io_uring_params params{};
+			mRing = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+			if (mRing < 0)
+			{
+				mRing = -1;
+				return -1;
+			}
+
+			// Single mmap rings and timed waits keep this engine simple, both arrived in 5.11.
+			if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 || (params.features & IORING_FEAT_EXT_ARG) == 0)
+			{
+				close(mRing);
+				mRing = -1;
+				return -1;
+			}
+
+			size_t submissionSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+			size_t completionSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			mRingMemorySize = std::max(submissionSize, completionSize);
+			mRingMemory = mmap(nullptr, mRingMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQ_RING);
+
+			if (mRingMemory == MAP_FAILED)
+			{
+				mRingMemory = nullptr;
+				return -1;
+			}
+
+			char* base = static_cast<char*>(mRingMemory);
+			mSqHead		= reinterpret_cast<uint32_t*>(base + params.sq_off.head);
+			mSqTail		= reinterpret_cast<uint32_t*>(base + params.sq_off.tail);
+			mSqMask		= *reinterpret_cast<uint32_t*>(base + params.sq_off.ring_mask);
+			mSqArray	= reinterpret_cast<uint32_t*>(base + params.sq_off.array);
+			mCqHead		= reinterpret_cast<uint32_t*>(base + params.cq_off.head);
+			mCqTail		= reinterpret_cast<uint32_t*>(base + params.cq_off.tail);
+			mCqMask		= *reinterpret_cast<uint32_t*>(base + params.cq_off.ring_mask);
+			mCqes		= reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+			mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			void* sqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES);
+
+			if (sqes == MAP_FAILED)
+			{
+				return -1;
+			}
+
+			mSqes = static_cast<io_uring_sqe*>(sqes);
+
+			// Register the provided buffer ring the multishot receives pick their buffers from.
+			mBufferRingSize = bufferCount * sizeof(io_uring_buf);
+			void* bufferRing = mmap(nullptr, mBufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+			if (bufferRing == MAP_FAILED)
+			{
+				return -1;
+			}
+
+			mBufferRing = static_cast<io_uring_buf_ring*>(bufferRing);
+
+			io_uring_buf_reg registration{};
+			registration.ring_addr = reinterpret_cast<uint64_t>(mBufferRing);
+			registration.ring_entries = bufferCount;
+			registration.bgid = 0;
+
+			if (syscall(__NR_io_uring_register, mRing, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+			{
+				return -1;
+			}
+
+			mBufferMask = bufferCount - 1;
+			mBufferSize = bufferSize;
+			mBuffers.resize(static_cast<size_t>(bufferCount) * bufferSize);
+			mReady.resize(bufferCount);
+
+			for (uint32_t i = 0; i < bufferCount; i++)
+			{
+				RecycleBuffer(static_cast<uint16_t>(i));
+			}
+
+			// Every receive reserves room for the sender address ahead of the payload.
+			mReceiveHeader = {};
+			mReceiveHeader.msg_namelen = sizeof(sockaddr_in);
+
+			// Multishot recvmsg arrived in 6.0, one kernel after the buffer ring, and older kernels reject it with EINVAL.
+			SOCKET probe = socket(AF_INET, SOCK_DGRAM, 0);
+
+			if (probe == INVALID_SOCKET)
+			{
+				return -1;
+			}
+
+			int8_t armed = ArmReceive(probe, SendType::UNICAST);
+			CancelReceive(probe);
+			closesocket(probe);
+
+			bool supported = armed == 0 && mReceiveError == 0;
+			mReceiveError = 0;
+
+			return supported ? 0 : -1;
+		}
+
+		int8_t UDP_Uring::ArmReceive(const SOCKET sock, const SendType type)
+		{
+			if (mRing == -1 || PrepareReceive(sock, type) < 0)
+			{
+				return -1;
+			}
+
+			return Submit(0, 0);
+		}
+
+		void UDP_Uring::CancelReceive(const SOCKET sock)
+		{
+			if (mRing == -1)
+			{
+				return;
+			}
+
+			mStarved.erase(std::remove_if(mStarved.begin(), mStarved.end(),
+				[sock](const std::pair<SOCKET, SendType>& i) { return i.first == sock; }), mStarved.end());
+
+			io_uring_sqe* sqe = GetSubmissionEntry();
+
+			if (sqe == nullptr)
+			{
+				return;
+			}
+
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->fd = sock;
+			sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+			sqe->user_data = (URING_OP_SYNC << 56) | ++mSyncSequence;
+
+			WaitForSync();
+		}
+
+		int32_t UDP_Uring::TakePackets(std::span<UringPacket> packets, const int32_t timeoutMSecs)
+		{
+			if (mRing == -1)
+			{
+				return -1;
+			}
+
+			Reap();
+
+			if (mReadyCount == 0 && mReceiveError == 0 && timeoutMSecs != 0)
+			{
+				if (Submit(1, timeoutMSecs) < 0)
+				{
+					return -1;
+				}
+
+				Reap();
+			}
+
+			// Post any receives re-armed while reaping.
+			if (Submit(0, 0) < 0)
+			{
+				return -1;
+			}
+
+			// Report a failed receive once the packets that arrived before it are gone.
+			if (mReadyCount == 0 && mReceiveError != 0)
+			{
+				errno = -mReceiveError;
+				mReceiveError = 0;
+				return -1;
+			}
+
+			uint32_t taken = 0;
+			while (taken < packets.size() && mReadyCount > 0)
+			{
+				packets[taken++] = mReady[mReadyHead];
+				mReadyHead = (mReadyHead + 1) & mBufferMask;
+				mReadyCount--;
+			}
+
+			return static_cast<int32_t>(taken);
+		}
+
+		void UDP_Uring::ReleasePacket(const UringPacket& packet)
+		{
+			if (mRing == -1)
+			{
+				return;
+			}
+
+			RecycleBuffer(packet.bufferId);
+
+			// A buffer is free again, restart any receive that stopped for lack of one.
+			if (!mStarved.empty())
+			{
+				for (const auto& i : mStarved)
+				{
+					PrepareReceive(i.first, i.second);
+				}
+
+				mStarved.clear();
+				Submit(0, 0);
+			}
+		}
+
+		io_uring_sqe* UDP_Uring::GetSubmissionEntry()
+		{
+			uint32_t head = __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+			uint32_t tail = *mSqTail;
+
+			if (tail - head > mSqMask)
+			{
+				Submit(0, 0);
+				head = __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+
+				if (tail - head > mSqMask)
+				{
+					return nullptr;
+				}
+			}
+
+			uint32_t index = tail & mSqMask;
+			io_uring_sqe* sqe = &mSqes[index];
+			memset(sqe, 0, sizeof(io_uring_sqe));
+			mSqArray[index] = index;
+
+			__atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+			mSqPending++;
+
+			return sqe;
+		}
+
+		int8_t UDP_Uring::Submit(const uint32_t waitCount, const int32_t timeoutMSecs)
+		{
+			if (mSqPending == 0 && waitCount == 0)
+			{
+				return 0;
+			}
+
+			unsigned int flags = 0;
+			io_uring_getevents_arg argument{};
+			__kernel_timespec timeout{};
+			void* argumentPointer = nullptr;
+			size_t argumentSize = 0;
+
+			if (waitCount > 0)
+			{
+				flags |= IORING_ENTER_GETEVENTS;
+
+				if (timeoutMSecs >= 0)
+				{
+					timeout.tv_sec = timeoutMSecs / 1000;
+					timeout.tv_nsec = static_cast<long long>(timeoutMSecs % 1000) * 1000000;
+					argument.ts = reinterpret_cast<uint64_t>(&timeout);
+					argumentPointer = &argument;
+					argumentSize = sizeof(argument);
+					flags |= IORING_ENTER_EXT_ARG;
+				}
+			}
+
+			long submitted = syscall(__NR_io_uring_enter, mRing, mSqPending, waitCount, flags, argumentPointer, argumentSize);
+
+			if (submitted < 0)
+			{
+				// A timed out or interrupted wait still submitted what it could.
+				if (errno == ETIME || errno == EINTR)
+				{
+					return 0;
+				}
+
+				return -1;
+			}
+
+			mSqPending -= std::min<uint32_t>(mSqPending, static_cast<uint32_t>(submitted));
+			return 0;
+		}
+
+		void UDP_Uring::Reap()
+		{
+			uint32_t head = *mCqHead;
+			uint32_t tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+
+			for (; head != tail; head++)
+			{
+				const io_uring_cqe& cqe = mCqes[head & mCqMask];
+				uint64_t operation = cqe.user_data >> 56;
+
+				if (operation == URING_OP_SYNC)
+				{
+					if ((cqe.user_data & 0xFFFFFFFF) == mSyncSequence)
+					{
+						mSyncResult = cqe.res;
+						mSyncComplete = true;
+					}
+					continue;
+				}
+
+				if (operation != URING_OP_RECEIVE)
+				{
+					continue;
+				}
+
+				SendType type = static_cast<SendType>((cqe.user_data >> 32) & 0xFF);
+				SOCKET sock = static_cast<SOCKET>(cqe.user_data & 0xFFFFFFFF);
+
+				if (cqe.res >= 0 && (cqe.flags & IORING_CQE_F_BUFFER) != 0)
+				{
+					uint16_t bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+					char* buffer = &mBuffers[static_cast<size_t>(bufferId) * mBufferSize];
+					const io_uring_recvmsg_out* out = reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+
+					// Buffer layout: header, reserved name area, reserved control area, payload.
+					char* name = buffer + sizeof(io_uring_recvmsg_out);
+					char* payload = name + mReceiveHeader.msg_namelen + mReceiveHeader.msg_controllen;
+					uint32_t available = static_cast<uint32_t>(cqe.res) - static_cast<uint32_t>(payload - buffer);
+
+					if (mReadyCount > mBufferMask)
+					{
+						RecycleBuffer(bufferId);
+					}
+					else
+					{
+						UringPacket& packet = mReady[(mReadyHead + mReadyCount) & mBufferMask];
+						packet.type = type;
+						packet.socket = sock;
+						packet.data = payload;
+						packet.size = std::min(out->payloadlen, available);
+						packet.truncated = (out->flags & MSG_TRUNC) != 0;
+						packet.bufferId = bufferId;
+						packet.sender = {};
+
+						if (out->namelen >= sizeof(sockaddr_in))
+						{
+							memcpy(&packet.sender, name, sizeof(sockaddr_in));
+						}
+
+						mReadyCount++;
+					}
+				}
+
+				// The multishot receive has ended; restart it unless it was cancelled or the socket went away.
+				if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+				{
+					if (cqe.res == -ENOBUFS)
+					{
+						mStarved.push_back({ sock, type });
+					}
+					else if (cqe.res >= 0)
+					{
+						PrepareReceive(sock, type);
+					}
+					else if (cqe.res != -ECANCELED)
+					{
+						if (mReceiveError == 0)
+						{
+							mReceiveError = cqe.res;
+						}
+
+						// An error queued on the socket, such as a refused port, leaves the socket usable.
+						if (cqe.res != -EBADF && cqe.res != -ENOTSOCK && cqe.res != -EINVAL && cqe.res != -EOPNOTSUPP)
+						{
+							PrepareReceive(sock, type);
+						}
+					}
+				}
+			}
+
+			__atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+		}
+
+		int32_t UDP_Uring::WaitForSync()
+		{
+			mSyncComplete = false;
+
+			while (!mSyncComplete)
+			{
+				if (Submit(1, -1) < 0)
+				{
+					return -errno;
+				}
+
+				Reap();
+			}
+
+			return mSyncResult;
+		}
+
+		int8_t UDP_Uring::PrepareReceive(const SOCKET sock, const SendType type)
+		{
+			io_uring_sqe* sqe = GetSubmissionEntry();
+
+			if (sqe == nullptr)
+			{
+				return -1;
+			}
+
+			sqe->opcode = IORING_OP_RECVMSG;
+			sqe->fd = sock;
+			sqe->addr = reinterpret_cast<uint64_t>(&mReceiveHeader);
+			sqe->len = 1;
+			sqe->flags = IOSQE_BUFFER_SELECT;
+			sqe->ioprio = IORING_RECV_MULTISHOT;
+			sqe->buf_group = 0;
+			sqe->user_data = (URING_OP_RECEIVE << 56) | (static_cast<uint64_t>(type) << 32) | static_cast<uint32_t>(sock);
+
+			return 0;
+		}
+
+		void UDP_Uring::RecycleBuffer(const uint16_t bufferId)
+		{
+			// Only the address, length and id are written, the tail shares storage with the first entry.
+			// Entries are indexed from the ring base since the header's flexible array is offset in C++.
+			uint16_t tail = mBufferRing->tail;
+			io_uring_buf* entry = reinterpret_cast<io_uring_buf*>(mBufferRing) + (tail & mBufferMask);
+			entry->addr = reinterpret_cast<uint64_t>(&mBuffers[static_cast<size_t>(bufferId) * mBufferSize]);
+			entry->len = mBufferSize;
+			entry->bid = bufferId;
+
+			__atomic_store_n(&mBufferRing->tail, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+		}
+#else
+		UDP_Uring::UDP_Uring() {}
+
+		UDP_Uring::~UDP_Uring() {}
+
+		int8_t UDP_Uring::Initialize(const uint32_t entries, const uint32_t bufferCount, const uint32_t bufferSize)
+		{
+			// io_uring only exists on linux.
+			return -1;
+		}
+
+		int8_t UDP_Uring::ArmReceive(const SOCKET sock, const SendType type)
+		{
+			return -1;
+		}
+
+		void UDP_Uring::CancelReceive(const SOCKET sock) {}
+
+		int32_t UDP_Uring::TakePackets(std::span<UringPacket> packets, const int32_t timeoutMSecs)
+		{
+			return -1;
+		}
+
+		void UDP_Uring::ReleasePacket(const UringPacket& packet) {}
+#endif
+	}
+}
@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file		udp_uring.h
+//!
+//! @brief		An io_uring engine for the udp client's receive path.
+//!
+//! @author		Chip Brommer
+//!
+//! @date		< 04 / 30 / 2023 > Initial Start Date
+//!
+/*****************************************************************************/
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include "udp_client.h"					// Socket types and SendType
+#if defined __linux__
+#include <linux/io_uring.h>				// io_uring structures
+#endif
+//
+//	Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_UDP_URING				// Define the cpp UDP io_uring class.
+#define     CPP_UDP_URING
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+	namespace Communications
+	{
+		constexpr static uint32_t	UDP_URING_DEFAULT_ENTRIES		= 256;
+		constexpr static uint32_t	UDP_URING_DEFAULT_BUFFER_COUNT	= 1024;
+		constexpr static uint32_t	UDP_URING_DEFAULT_BUFFER_SIZE	= 2048;
+
+		/// <summary>Represents a datagram taken from the io_uring buffer ring</summary>
+		struct UringPacket
+		{
+			SendType			type		= SendType::UNICAST;	// Kind of socket the datagram arrived on
+			SOCKET				socket		= INVALID_SOCKET;		// Socket the datagram arrived on
+			const char*			data		= nullptr;				// Received data, valid until the packet is released
+			uint32_t			size		= 0;					// Number of bytes received
+			sockaddr_in			sender		= {};					// Address and port of the sender, network byte order
+			bool				truncated	= false;				// True if the datagram was larger than a ring buffer
+			uint16_t			bufferId	= 0;					// Ring buffer holding the data
+		};
+
+		/// <summary>A class driving a single io_uring instance with multishot receives and a provided buffer ring. 
+		/// Not thread safe, every call must come from one thread at a time.</summary>
+		class UDP_Uring
+		{
+		public:
+			/// <summary>Default Constructor</summary>
+			UDP_Uring();
+
+			/// <summary>Default Deconstructor</summary>
+			~UDP_Uring();
+
+			/// <summary>Creates the ring, registers the receive buffer ring and checks the kernel runs multishot recvmsg (6.0+)</summary>
+			/// <param name="entries"> -[in]- Number of submission queue entries</param>
+			/// <param name="bufferCount"> -[in]- Number of receive buffers, must be a power of two</param>
+			/// <param name="bufferSize"> -[in]- Size of each receive buffer</param>
+			/// <returns>0 if successful, -1 if io_uring is not available.</returns>
+			int8_t Initialize(const uint32_t entries, const uint32_t bufferCount, const uint32_t bufferSize);
+
+			/// <summary>Posts a multishot recvmsg on a socket that stays armed until the socket is closed</summary>
+			/// <param name="sock"> -[in]- Socket to receive on</param>
+			/// <param name="type"> -[in]- Kind of socket, reported with each packet</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t ArmReceive(const SOCKET sock, const SendType type);
+
+			/// <summary>Cancels the multishot receive on a socket, must be called before the socket is closed</summary>
+			/// <param name="sock"> -[in]- Socket to stop receiving on</param>
+			void CancelReceive(const SOCKET sock);
+
+			/// <summary>Takes received datagrams out of the ring, waiting for the first one if none are ready</summary>
+			/// <param name="packets"> -[out]- Packets to be filled, each must be handed back with ReleasePacket</param>
+			/// <param name="timeoutMSecs"> -[in]- Maximum number of milliseconds to wait, 0 does not wait</param>
+			/// <returns>0+ if successful (number of packets taken), -1 if fails or a receive failed since the last call
+			/// (errno holds the receive's error once every packet received before it has been taken).</returns>
+			int32_t TakePackets(std::span<UringPacket> packets, const int32_t timeoutMSecs);
+
+			/// <summary>Hands a packet's buffer back to the kernel</summary>
+			/// <param name="packet"> -[in]- Packet previously returned by TakePackets</param>
+			void ReleasePacket(const UringPacket& packet);
+
+		protected:
+		private:
+#if defined __linux__
+			/// <summary>Gets a free submission queue entry, submitting pending entries if the queue is full</summary>
+			/// <returns>Pointer to a cleared entry, nullptr if none could be made free.</returns>
+			io_uring_sqe* GetSubmissionEntry();
+
+			/// <summary>Submits pending entries and optionally waits for completions</summary>
+			/// <param name="waitCount"> -[in]- Number of completions to wait for</param>
+			/// <param name="timeoutMSecs"> -[in]- Maximum number of milliseconds to wait, -1 waits forever</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t Submit(const uint32_t waitCount, const int32_t timeoutMSecs);
+
+			/// <summary>Processes every completion in the completion queue</summary>
+			void Reap();
+
+			/// <summary>Submits pending entries and waits until the synchronous operation in flight completes</summary>
+			/// <returns>Result of the operation, negative errno if it failed.</returns>
+			int32_t WaitForSync();
+
+			/// <summary>Writes a multishot recvmsg entry for a socket, submitted with the next Submit</summary>
+			/// <param name="sock"> -[in]- Socket to receive on</param>
+			/// <param name="type"> -[in]- Kind of socket</param>
+			/// <returns>0 if successful, -1 if fails.</returns>
+			int8_t PrepareReceive(const SOCKET sock, const SendType type);
+
+			/// <summary>Hands a buffer back to the kernel's buffer ring</summary>
+			/// <param name="bufferId"> -[in]- Buffer to be returned</param>
+			void RecycleBuffer(const uint16_t bufferId);
+
+			// Variables
+			int							mRing;					// io_uring FD
+			void*						mRingMemory;			// Mapped submission and completion rings
+			size_t						mRingMemorySize;		// Size of the mapped rings
+			io_uring_sqe*				mSqes;					// Mapped submission queue entries
+			size_t						mSqesSize;				// Size of the mapped submission queue entries
+			uint32_t*					mSqHead;				// Submission queue head, owned by the kernel
+			uint32_t*					mSqTail;				// Submission queue tail, owned by us
+			uint32_t					mSqMask;				// Submission queue index mask
+			uint32_t*					mSqArray;				// Submission queue index array
+			uint32_t					mSqPending;				// Entries written but not yet submitted
+			uint32_t*					mCqHead;				// Completion queue head, owned by us
+			uint32_t*					mCqTail;				// Completion queue tail, owned by the kernel
+			uint32_t					mCqMask;				// Completion queue index mask
+			io_uring_cqe*				mCqes;					// Completion queue entries
+			io_uring_buf_ring*			mBufferRing;			// Provided buffer ring shared with the kernel
+			size_t						mBufferRingSize;		// Size of the mapped buffer ring
+			uint32_t					mBufferMask;			// Buffer ring index mask
+			uint32_t					mBufferSize;			// Size of each receive buffer
+			std::vector<char>			mBuffers;				// Receive buffer storage
+			msghdr						mReceiveHeader;			// Layout of every multishot recvmsg
+			std::vector<UringPacket>	mReady;					// Received packets waiting to be taken
+			uint32_t					mReadyHead;				// Index of the oldest ready packet
+			uint32_t					mReadyCount;			// Number of ready packets
+			std::vector<std::pair<SOCKET, SendType>>	mStarved;	// Sockets whose receive stopped because the buffer ring ran dry
+			uint32_t					mSyncSequence;			// Sequence of the last synchronous cancel submitted
+			int32_t						mSyncResult;			// Result of the last synchronous operation
+			bool						mSyncComplete;			// True once the last synchronous operation has completed
+			int32_t						mReceiveError;			// First receive failure since the last TakePackets, negative errno, 0 if none
+#endif
+		};
+	}
+}
+
+#endif		// CPP_UDP_URING
@@ -1,5 +1,10 @@
 ﻿#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
 #include "Source/udp_client.h"
+#include "Source/udp_uring.h"
+#include "Source/udp_latency_histogram.h"
 
 #define UNICAST_SEND_TEST
 //#define BROADCAST_SEND_TEST
@@ -9,11 +14,19 @@
 //#define BROADCAST_RECV_SPECIFIC_TEST
 //#define MULTICAST_RECV_TEST
 //#define MULTICAST_RECV_SPECIFIC_TEST
+//#define URING_LOOPBACK_TEST
+//#define PINNED_PEER_BENCH
+//#define BUSY_POLL_BENCH
+//#define GRO_TIMESTAMP_TEST
 
 int main()
 {
 	std::cout << "Hello CMake." << std::endl;
+#ifdef URING_LOOPBACK_TEST
+	Essentials::Communications::UDP_Client* udp = new Essentials::Communications::UDP_Client(Essentials::Communications::IoBackend::IO_URING);
+#else
 	Essentials::Communications::UDP_Client* udp = new Essentials::Communications::UDP_Client();
+#endif
 	std::cout << Essentials::Communications::UdpClientVersion;
 
 #ifdef BROADCAST_SEND_TEST
@@ -94,6 +107,162 @@ int main()
 
 	char buffer[200];
 	int size = sizeof(buffer);
+#elif defined URING_LOOPBACK_TEST
+	if (udp->GetIoBackend() != Essentials::Communications::IoBackend::IO_URING)
+	{
+		std::cout << "io_uring not available, using POSIX backend." << std::endl;
+	}
+
+	if (udp->ConfigureThisClient("127.0.0.1", 8000) < 0)
+	{
+		std::cout << udp->GetLastError() << std::endl;
+	}
+
+	if (udp->SetUnicastDestination("127.0.0.1", 8000) < 0)
+	{
+		std::cout << udp->GetLastError() << std::endl;
+	}
+
+	if (udp->OpenUnicast() < 0)
+	{
+		std::cout << udp->GetLastError() << std::endl;
+	}
+
+	std::string buffer = "Hello Loopback!";
+	Essentials::Communications::UringPacket packets[16];
+#elif defined PINNED_PEER_BENCH
+	// Loopback round of sends and receives, once through sendto/recvfrom and once pinned with send/recv.
+	Essentials::Communications::UDP_Client peer;
+	peer.ConfigureThisClient("127.0.0.1", 8011);
+	peer.SetUnicastDestination("127.0.0.1", 8010);
+	peer.OpenUnicast();
+
+	udp->ConfigureThisClient("127.0.0.1", 8010);
+	udp->SetUnicastDestination("127.0.0.1", 8011);
+	udp->OpenUnicast();
+
+	const int rounds = 200000;
+	char payload[64] = {};
+	char inbuffer[64];
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		if (pass == 1 && (udp->PinUnicastPeer() < 0 || peer.PinUnicastPeer() < 0))
+		{
+			std::cout << udp->GetLastError() << std::endl;
+			break;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		int received = 0;
+
+		for (int i = 0; i < rounds; i++)
+		{
+			udp->SendUnicast(payload, sizeof(payload));
+			if (peer.ReceiveUnicast(inbuffer, sizeof(inbuffer)) > 0)
+			{
+				received++;
+			}
+		}
+
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		std::cout << (pass == 0 ? "sendto/recvfrom: " : "pinned send/recv: ") << elapsed / rounds << " ns per round, "
+			<< received << "/" << rounds << " received" << std::endl;
+	}
+
+	delete udp;
+	return 0;
+#elif defined BUSY_POLL_BENCH
+	// Loopback ping-pong against an echo thread, once sleeping in poll and once spinning before it.
+	Essentials::Communications::UDP_Client peer;
+	peer.ConfigureThisClient("127.0.0.1", 8013);
+	peer.SetUnicastDestination("127.0.0.1", 8012);
+	peer.OpenUnicast();
+
+	udp->ConfigureThisClient("127.0.0.1", 8012);
+	udp->SetUnicastDestination("127.0.0.1", 8013);
+	udp->OpenUnicast();
+
+	std::atomic<bool> echoing = true;
+	std::thread echo([&peer, &echoing]()
+		{
+			char echobuffer[64];
+
+			while (echoing)
+			{
+				int32_t length = peer.ReceiveUnicastSpin(echobuffer, sizeof(echobuffer), 10);
+				if (length > 0)
+				{
+					peer.SendUnicast(echobuffer, length);
+				}
+			}
+		});
+
+	const int rounds = 100000;
+	const uint32_t budgets[] = { 0, 50 };
+	char payload[64] = {};
+	char inbuffer[64];
+
+	for (uint32_t budget : budgets)
+	{
+		udp->SetBusyPoll(budget);
+		Essentials::Communications::LatencyHistogram histogram;
+
+		for (int i = 0; i < rounds; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			udp->SendUnicast(payload, sizeof(payload));
+			if (udp->ReceiveUnicastSpin(inbuffer, sizeof(inbuffer), 1000) > 0)
+			{
+				histogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			}
+		}
+
+		std::cout << "busy poll " << budget << " us: " << histogram.Summary() << std::endl;
+	}
+
+	echoing = false;
+	echo.join();
+
+	delete udp;
+	return 0;
+#elif defined GRO_TIMESTAMP_TEST
+	// One segmented send coalesced back on receive, with timestamps on the control data must still carry the segment size.
+	Essentials::Communications::UDP_Client peer;
+	peer.ConfigureThisClient("127.0.0.1", 8015);
+	peer.SetUnicastDestination("127.0.0.1", 8014);
+	peer.OpenUnicast();
+
+	udp->ConfigureThisClient("127.0.0.1", 8014);
+	udp->SetUnicastDestination("127.0.0.1", 8015);
+	udp->OpenUnicast();
+
+	if (peer.SetReceiveCoalescing(true) < 0 || peer.EnableReceiveTimestamps(true) < 0)
+	{
+		std::cout << peer.GetLastError() << std::endl;
+	}
+
+	char payload[4000] = {};
+	if (udp->SendUnicastSegmented(payload, sizeof(payload), 1000) < 0)
+	{
+		std::cout << udp->GetLastError() << std::endl;
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	std::vector<char> inbuffer(Essentials::Communications::UDP_MAX_DATAGRAM_SIZE);
+	Essentials::Communications::CoalescedDatagrams datagrams;
+
+	if (peer.ReceiveUnicastCoalesced(inbuffer.data(), (uint32_t)inbuffer.size(), datagrams) < 0)
+	{
+		std::cout << peer.GetLastError() << std::endl;
+	}
+
+	std::cout << "received " << datagrams.size << " bytes, segment size " << datagrams.segmentSize << ", " << datagrams.Count()
+		<< " datagrams, timestamp " << datagrams.timestamp << std::endl;
+
+	delete udp;
+	return 0;
 #endif // TESTS
 
 	int sendcount = 0;
@@ -223,6 +392,25 @@ int main()
 		sleep(1);
 #endif
 
+#elif defined URING_LOOPBACK_TEST
+		if (udp->SendUnicast(buffer.c_str(), (uint32_t)buffer.length()) < 1)
+		{
+			std::cout << "FAIL: " << udp->GetLastError() << std::endl;
+		}
+
+		int taken = udp->TakePackets(packets, 1000);
+		if (taken == -1)
+		{
+			std::cout << udp->GetLastError() << std::endl;
+		}
+
+		for (int i = 0; i < taken; i++)
+		{
+			std::cout << "Received data from " << ntohs(packets[i].sender.sin_port) << ": " << std::string(packets[i].data, packets[i].size) << std::endl;
+			udp->ReleasePacket(packets[i]);
+		}
+
+		sleep(1);
 #endif // TESTS
 	}
 